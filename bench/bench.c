@@ -0,0 +1,511 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "memprof.h"
+#include "perf.h"
+#include "shipovnik.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#else
+#define HAVE_RDTSC 0
+#endif
+
+// Messages up to this size are signed from one buffer, larger ones are
+// absorbed chunk by chunk so that gigabyte messages need no memory.
+#define CONTIGUOUS_BYTES (64u << 20)
+#define CHUNK_BYTES (1u << 20)
+#define MAX_SIZES 32
+
+enum { OP_KEYGEN = 1, OP_SIGN = 2, OP_VERIFY = 4 };
+
+typedef struct {
+  const char *op;
+  uint64_t msg_len;
+  int streamed;
+  size_t count;
+  uint64_t min_ns;
+  uint64_t p50_ns;
+  uint64_t p99_ns;
+  uint64_t max_ns;
+  double ops_per_sec;
+  double cycles_per_op;
+  int counted; ///< Non-zero if the counters were read.
+  uint64_t before[PERF_EVENTS];
+  uint64_t after[PERF_EVENTS];
+  int profiled; ///< Non-zero if the memory use was recorded.
+  memprof_usage_t memory;
+} result_t;
+
+typedef struct {
+  uint64_t *ns;
+  uint64_t total_ns;
+  uint64_t total_cycles;
+  uint64_t before[PERF_EVENTS];
+  uint64_t after[PERF_EVENTS];
+  memprof_usage_t memory;
+} samples_t;
+
+// counters read around the timed calls, `NULL` if not requested
+static perf_counters_t *counters = NULL;
+// non-zero to record the memory use of one more untimed call
+static int profile_memory = 0;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t cycles(void) {
+#if HAVE_RDTSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static int compare_u64(const void *a, const void *b) {
+  const uint64_t x = *(const uint64_t *)a;
+  const uint64_t y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static long peak_rss_kb(void) {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage)) {
+    return -1;
+  }
+  return usage.ru_maxrss;
+}
+
+static int parse_size(const char *s, char **end, uint64_t *size) {
+  uint64_t value = strtoull(s, end, 10);
+  if (*end == s) {
+    return 1;
+  }
+  switch (**end) {
+  case 'G':
+    value <<= 10;
+    // fall through
+  case 'M':
+    value <<= 10;
+    // fall through
+  case 'K':
+    value <<= 10;
+    ++*end;
+    break;
+  default:
+    break;
+  }
+  *size = value;
+  return 0;
+}
+
+static size_t parse_sizes(const char *s, uint64_t *sizes) {
+  size_t count = 0;
+  char *end;
+  while (count < MAX_SIZES && 0 == parse_size(s, &end, &sizes[count])) {
+    ++count;
+    if (',' != *end) {
+      return '\0' == *end ? count : 0;
+    }
+    s = end + 1;
+  }
+  return 0;
+}
+
+static int parse_ops(const char *s) {
+  static const char *names[] = {"keygen", "sign", "verify"};
+  int ops = 0;
+  while ('\0' != *s) {
+    const size_t len = strcspn(s, ",");
+    int found = 0;
+    for (int i = 0; i < 3; ++i) {
+      if (strlen(names[i]) == len && 0 == strncmp(s, names[i], len)) {
+        ops |= 1 << i;
+        found = 1;
+      }
+    }
+    if (!found) {
+      return 0;
+    }
+    s += len + (',' == s[len]);
+  }
+  return ops;
+}
+
+static shipovnik_message_t *absorb(const uint8_t *chunk, uint64_t len) {
+  shipovnik_message_t *msg = shipovnik_message_new();
+  if (NULL == msg) {
+    fputs("out of memory\n", stderr);
+    exit(1);
+  }
+  for (; len > CHUNK_BYTES; len -= CHUNK_BYTES) {
+    shipovnik_message_update(msg, chunk, CHUNK_BYTES);
+  }
+  shipovnik_message_update(msg, chunk, (size_t)len);
+  return msg;
+}
+
+static void sign(const uint8_t *sk, const uint8_t *buf, uint64_t len,
+                 uint8_t *sig) {
+  size_t sig_len;
+  if (len <= CONTIGUOUS_BYTES) {
+    shipovnik_sign(sk, buf, (size_t)len, sig, &sig_len);
+    return;
+  }
+  shipovnik_message_t *msg = absorb(buf, len);
+  shipovnik_sign_absorbed(sk, msg, sig, &sig_len);
+  shipovnik_message_free(msg);
+}
+
+static int verify(const uint8_t *pk, const uint8_t *sig, const uint8_t *buf,
+                  uint64_t len) {
+  if (len <= CONTIGUOUS_BYTES) {
+    return shipovnik_verify(pk, sig, buf, (size_t)len);
+  }
+  shipovnik_message_t *msg = absorb(buf, len);
+  const int res = shipovnik_verify_absorbed(pk, sig, msg);
+  shipovnik_message_free(msg);
+  return res;
+}
+
+static void summarize(const char *op, uint64_t msg_len, samples_t *samples,
+                      size_t count, result_t *result) {
+  qsort(samples->ns, count, sizeof(uint64_t), compare_u64);
+  result->op = op;
+  result->msg_len = msg_len;
+  result->streamed = msg_len > CONTIGUOUS_BYTES;
+  result->count = count;
+  result->min_ns = samples->ns[0];
+  result->p50_ns = samples->ns[(count - 1) / 2];
+  result->p99_ns = samples->ns[(count - 1) * 99 / 100];
+  result->max_ns = samples->ns[count - 1];
+  result->ops_per_sec = (double)count * 1e9 / (double)samples->total_ns;
+  result->cycles_per_op =
+      HAVE_RDTSC ? (double)samples->total_cycles / (double)count : -1.0;
+  result->counted = NULL != counters;
+  memcpy(result->before, samples->before, sizeof(result->before));
+  memcpy(result->after, samples->after, sizeof(result->after));
+  result->profiled = profile_memory;
+  result->memory = samples->memory;
+}
+
+static void print_text(const result_t *r) {
+  printf("%-6s %12" PRIu64 " B  min %10.3f  p50 %10.3f  p99 %10.3f  "
+         "max %10.3f ms  %10.2f ops/s",
+         r->op, r->msg_len, (double)r->min_ns / 1e6, (double)r->p50_ns / 1e6,
+         (double)r->p99_ns / 1e6, (double)r->max_ns / 1e6, r->ops_per_sec);
+  if (r->cycles_per_op >= 0) {
+    printf("  %.3e cycles/op", r->cycles_per_op);
+  }
+  putchar('\n');
+  if (r->counted) {
+    perf_print(r->before, r->after, r->count);
+  }
+  if (r->profiled) {
+    if (r->memory.heap) {
+      printf("  heap peak %" PRId64 " B  %" PRIu64 " allocs  %" PRIu64
+             " B allocated",
+             r->memory.heap_peak, r->memory.allocations,
+             r->memory.allocated_bytes);
+    } else {
+      fputs("  heap n/a", stdout);
+    }
+    printf("  stack peak %zu B\n", r->memory.stack_peak);
+  }
+}
+
+// upper bound of the bucket holding the median call of a phase
+static uint64_t median_bound(const shipovnik_phase_stats_t *phase) {
+  uint64_t seen = 0;
+  int b = 0;
+  while (b < SHIPOVNIK_STATS_BUCKETS - 1 &&
+         2 * (seen += phase->buckets[b]) < phase->calls) {
+    ++b;
+  }
+  return (uint64_t)2 << b;
+}
+
+static void print_phases(const shipovnik_stats_t *stats) {
+  const char *unit = stats->ticks_are_cycles ? "cycles" : "ns";
+  for (int p = 0; p < SHIPOVNIK_PHASES; ++p) {
+    const shipovnik_phase_stats_t *phase = &stats->phases[p];
+    if (phase->calls) {
+      printf("%-10s %12" PRIu64 " calls %14.0f %s/call  median < %" PRIu64
+             " %s\n",
+             shipovnik_phase_name(p), phase->calls,
+             (double)phase->ticks / (double)phase->calls, unit,
+             median_bound(phase), unit);
+    }
+  }
+}
+
+static void print_json(const result_t *results, size_t count, size_t warmup,
+                       const shipovnik_stats_t *stats) {
+  printf("{\n  \"iterations\": %zu,\n  \"warmup\": %zu,\n  \"results\": [",
+         count ? results[0].count : 0, warmup);
+  for (size_t i = 0; i < count; ++i) {
+    const result_t *r = &results[i];
+    printf("%s\n    {\"op\": \"%s\", \"msg_bytes\": %" PRIu64
+           ", \"streamed\": %s, \"min_ns\": %" PRIu64 ", \"p50_ns\": %" PRIu64
+           ", \"p99_ns\": %" PRIu64 ", \"max_ns\": %" PRIu64
+           ", \"ops_per_sec\": %.3f, \"cycles_per_op\": ",
+           i ? "," : "", r->op, r->msg_len, r->streamed ? "true" : "false",
+           r->min_ns, r->p50_ns, r->p99_ns, r->max_ns, r->ops_per_sec);
+    if (r->cycles_per_op >= 0) {
+      printf("%.0f", r->cycles_per_op);
+    } else {
+      fputs("null", stdout);
+    }
+    if (r->counted) {
+      fputs(", \"counters\": {", stdout);
+      for (int e = 0; e < PERF_EVENTS; ++e) {
+        printf("%s\"%s\": ", e ? ", " : "", perf_event_name(e));
+        if (PERF_UNAVAILABLE == r->before[e] ||
+            PERF_UNAVAILABLE == r->after[e]) {
+          fputs("null", stdout);
+        } else {
+          printf("%.1f", (double)(r->after[e] - r->before[e]) / r->count);
+        }
+      }
+      putchar('}');
+    }
+    if (r->profiled) {
+      fputs(", \"memory\": {", stdout);
+      if (r->memory.heap) {
+        printf("\"heap_peak_bytes\": %" PRId64 ", \"allocations\": %" PRIu64
+               ", \"allocated_bytes\": %" PRIu64 ", ",
+               r->memory.heap_peak, r->memory.allocations,
+               r->memory.allocated_bytes);
+      }
+      printf("\"stack_peak_bytes\": %zu}", r->memory.stack_peak);
+    }
+    putchar('}');
+  }
+  fputs("\n  ],\n", stdout);
+  if (stats) {
+    printf("  \"ticks_are_cycles\": %s,\n  \"phases\": [",
+           stats->ticks_are_cycles ? "true" : "false");
+    for (int p = 0; p < SHIPOVNIK_PHASES; ++p) {
+      const shipovnik_phase_stats_t *phase = &stats->phases[p];
+      printf("%s\n    {\"phase\": \"%s\", \"calls\": %" PRIu64
+             ", \"ticks\": %" PRIu64 ", \"buckets\": [",
+             p ? "," : "", shipovnik_phase_name(p), phase->calls,
+             phase->ticks);
+      for (int b = 0; b < SHIPOVNIK_STATS_BUCKETS; ++b) {
+        printf("%s%" PRIu64, b ? ", " : "", phase->buckets[b]);
+      }
+      fputs("]}", stdout);
+    }
+    fputs("\n  ],\n", stdout);
+  }
+  printf("  \"peak_rss_kb\": %ld\n}\n", peak_rss_kb());
+}
+
+#define MEASURE(samples, count, warmup, call)                                  \
+  do {                                                                         \
+    for (size_t i_ = 0; i_ < (warmup); ++i_) {                                 \
+      call;                                                                    \
+    }                                                                          \
+    (samples)->total_ns = 0;                                                   \
+    (samples)->total_cycles = 0;                                               \
+    if (counters) {                                                            \
+      perf_read(counters, (samples)->before);                                  \
+    }                                                                          \
+    for (size_t i_ = 0; i_ < (count); ++i_) {                                  \
+      const uint64_t cycles_ = cycles();                                       \
+      const uint64_t start_ = now_ns();                                        \
+      call;                                                                    \
+      (samples)->ns[i_] = now_ns() - start_;                                   \
+      (samples)->total_cycles += cycles() - cycles_;                           \
+      (samples)->total_ns += (samples)->ns[i_];                                \
+    }                                                                          \
+    if (counters) {                                                            \
+      perf_read(counters, (samples)->after);                                   \
+    }                                                                          \
+    if (profile_memory) {                                                      \
+      memprof_begin();                                                         \
+      call;                                                                    \
+      memprof_end(&(samples)->memory);                                         \
+    }                                                                          \
+  } while (0)
+
+static void usage(void) {
+  fputs("usage: shipovnik_bench [-n iterations] [-w warmup] [-s sizes] "
+        "[-o ops] [-j] [-p] [-e] [-M]\n"
+        "  -s  comma separated message sizes with K, M, G suffixes "
+        "(1,1K,1M)\n"
+        "  -o  comma separated operations (keygen,sign,verify)\n"
+        "  -j  print results as JSON\n"
+        "  -p  print time spent in phases, if the library is built with "
+        "SHIPOVNIK_STATS\n"
+        "  -e  print hardware counters per operation\n"
+        "  -M  print peak heap, allocations and peak stack of an operation\n",
+        stderr);
+}
+
+int main(int argc, char *argv[]) {
+  size_t count = 20;
+  size_t warmup = 1;
+  uint64_t sizes[MAX_SIZES] = {1, 1u << 10, 1u << 20};
+  size_t size_count = 3;
+  int ops = OP_KEYGEN | OP_SIGN | OP_VERIFY;
+  int json = 0;
+  int phases = 0;
+  perf_counters_t perf;
+
+  int opt;
+  while (-1 != (opt = getopt(argc, argv, "n:w:s:o:jpeM"))) {
+    switch (opt) {
+    case 'n':
+      count = strtoul(optarg, NULL, 10);
+      break;
+    case 'w':
+      warmup = strtoul(optarg, NULL, 10);
+      break;
+    case 's':
+      size_count = parse_sizes(optarg, sizes);
+      break;
+    case 'o':
+      ops = parse_ops(optarg);
+      break;
+    case 'j':
+      json = 1;
+      break;
+    case 'p':
+      phases = 1;
+      break;
+    case 'e':
+      counters = &perf;
+      break;
+    case 'M':
+      profile_memory = 1;
+      break;
+    default:
+      usage();
+      return 1;
+    }
+  }
+  if (0 == count || 0 == size_count || 0 == ops || optind != argc) {
+    usage();
+    return 1;
+  }
+  if (phases && shipovnik_stats_enable(1)) {
+    fputs("the library is built without SHIPOVNIK_STATS\n", stderr);
+    return 1;
+  }
+  if (counters && 0 == perf_open(counters)) {
+    fputs("warning: performance counters are not available\n", stderr);
+  }
+
+  uint64_t max_size = 0;
+  for (size_t i = 0; i < size_count; ++i) {
+    max_size = sizes[i] > max_size ? sizes[i] : max_size;
+  }
+  max_size = max_size > CONTIGUOUS_BYTES ? CHUNK_BYTES : max_size;
+
+  uint8_t sk[SHIPOVNIK_SECRETKEYBYTES];
+  uint8_t pk[SHIPOVNIK_PUBLICKEYBYTES];
+  uint8_t *sig = malloc(SHIPOVNIK_SIGBYTES);
+  uint8_t *buf = malloc(max_size ? (size_t)max_size : 1);
+  samples_t samples = {0};
+  samples.ns = malloc(count * sizeof(uint64_t));
+  result_t *results = malloc((1 + 2 * size_count) * sizeof(result_t));
+  if (NULL == sig || NULL == buf || NULL == samples.ns || NULL == results) {
+    fputs("out of memory\n", stderr);
+    return 1;
+  }
+  for (uint64_t i = 0; i < max_size; ++i) {
+    buf[i] = (uint8_t)(i * 251 + 7);
+  }
+
+  size_t result_count = 0;
+  if (ops & OP_KEYGEN) {
+    MEASURE(&samples, count, warmup, shipovnik_generate_keys(sk, pk));
+    summarize("keygen", 0, &samples, count, &results[result_count]);
+    if (!json) {
+      print_text(&results[result_count]);
+    }
+    ++result_count;
+  }
+
+  shipovnik_generate_keys(sk, pk);
+  for (size_t s = 0; s < size_count; ++s) {
+    const uint64_t len = sizes[s];
+    if (ops & OP_SIGN) {
+      MEASURE(&samples, count, warmup, sign(sk, buf, len, sig));
+      summarize("sign", len, &samples, count, &results[result_count]);
+      if (!json) {
+        print_text(&results[result_count]);
+      }
+      ++result_count;
+    }
+    if (ops & OP_VERIFY) {
+      int failed = 0;
+      sign(sk, buf, len, sig);
+      MEASURE(&samples, count, warmup, failed |= verify(pk, sig, buf, len));
+      if (failed) {
+        fprintf(stderr, "verification failed for %" PRIu64 " B\n", len);
+        return 1;
+      }
+      summarize("verify", len, &samples, count, &results[result_count]);
+      if (!json) {
+        print_text(&results[result_count]);
+      }
+      ++result_count;
+    }
+  }
+
+  shipovnik_stats_t stats;
+  shipovnik_stats_snapshot(&stats);
+  if (json) {
+    print_json(results, result_count, warmup, phases ? &stats : NULL);
+  } else {
+    if (phases) {
+      print_phases(&stats);
+    }
+    printf("peak RSS %ld KB\n", peak_rss_kb());
+  }
+  if (counters) {
+    perf_close(counters);
+  }
+  free(results);
+  free(samples.ns);
+  free(buf);
+  free(sig);
+  return 0;
+}
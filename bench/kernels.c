@@ -0,0 +1,423 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#define _GNU_SOURCE
+
+#include "genvector.h"
+#include "hash.h"
+#include "multiword.h"
+#include "params.h"
+#include "perf.h"
+#include "sign.h"
+#include "syndrome.h"
+#include "utils.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#ifndef STREEBOG_BACKEND
+#define STREEBOG_BACKEND "ref"
+#endif
+
+#define MAX_REPETITIONS 100
+#define NAME_BYTES 64
+
+// inputs and outputs of the kernels, filled once by `setup`
+static uint8_t sk[SHIPOVNIK_SECRETKEYBYTES];
+static uint8_t pk[SHIPOVNIK_PUBLICKEYBYTES];
+static uint8_t lanes_sk[SYNDROME_LANES][SHIPOVNIK_SECRETKEYBYTES];
+static uint8_t lanes_pk[SYNDROME_LANES][SHIPOVNIK_PUBLICKEYBYTES];
+static uint32_t entropy[N];
+static uint16_t sigma[N];
+static uint16_t pi[N];
+static uint64_t sort_buf[N];
+static uint8_t permuted[SHIPOVNIK_SECRETKEYBYTES];
+static uint8_t packed[SIGMA_PACKED_BYTES];
+static uint8_t response[STREEBOG_LANES][RESPONSE_BYTES(0)];
+static uint8_t digest[STREEBOG_LANES][GOST512_OUTPUT_BYTES];
+static uint8_t challenge[DELTA];
+static multiword_number_t shifted;
+static multiword_number_t scratch;
+static size_t bits;
+
+static void run_syndrome(void) { syndrome(H_PRIME, sk, pk); }
+
+static void run_syndrome_batch(void) {
+  const uint8_t *vs[SYNDROME_LANES];
+  uint8_t *ss[SYNDROME_LANES];
+  for (size_t l = 0; l < SYNDROME_LANES; ++l) {
+    vs[l] = lanes_sk[l];
+    ss[l] = lanes_pk[l];
+  }
+  syndrome_batch(H_PRIME, vs, ss, SYNDROME_LANES);
+}
+
+static void run_shuffle(void) { shuffle(entropy, pi, sort_buf, N); }
+
+static void run_apply_permutation(void) {
+  apply_permutation(sigma, sk, permuted, N);
+}
+
+static void run_check_permutation(void) { check_permutation(sigma); }
+
+static void run_pack_sigma(void) { pack_sigma(sigma, N, packed); }
+
+static void run_unpack_sigma(void) {
+  unpack_sigma(packed, SIGMA_PACKED_BYTES, pi);
+}
+
+static void run_h_3_delta_shift(void) {
+  multiword_number_free(h_3_delta_shift(digest[0], GOST512_OUTPUT_BYTES));
+}
+
+static void run_h_to_ternary_vec(void) {
+  // the conversion consumes its input, the copy is negligible
+  multiword_number_copy(shifted, scratch);
+  h_to_ternary_vec(scratch, challenge, DELTA);
+}
+
+static void run_streebog_sk(void) {
+  streebog_512_f(sk, SHIPOVNIK_SECRETKEYBYTES, digest[0]);
+}
+
+static void run_streebog_response(void) {
+  streebog_512_f(response[0], RESPONSE_BYTES(0), digest[0]);
+}
+
+static void run_streebog_response_multi(void) {
+  const uint8_t *bufs[STREEBOG_LANES];
+  uint8_t *results[STREEBOG_LANES];
+  for (size_t l = 0; l < STREEBOG_LANES; ++l) {
+    bufs[l] = response[l];
+    results[l] = digest[l];
+  }
+  streebog_512_f_multi(bufs, RESPONSE_BYTES(0), results, STREEBOG_LANES);
+}
+
+static void run_count_bits(void) {
+  count_bits(sk, SHIPOVNIK_SECRETKEYBYTES, &bits);
+}
+
+typedef struct {
+  const char *name;
+  void (*run)(void);
+} kernel_t;
+
+static const kernel_t kernels[] = {
+    {"syndrome", run_syndrome},
+    {"syndrome_batch/8", run_syndrome_batch},
+    {"shuffle", run_shuffle},
+    {"apply_permutation", run_apply_permutation},
+    {"check_permutation", run_check_permutation},
+    {"pack_sigma", run_pack_sigma},
+    {"unpack_sigma", run_unpack_sigma},
+    {"h_3_delta_shift", run_h_3_delta_shift},
+    {"h_to_ternary_vec", run_h_to_ternary_vec},
+    {"streebog_512_f/362/" STREEBOG_BACKEND, run_streebog_sk},
+    {"streebog_512_f/4706/" STREEBOG_BACKEND, run_streebog_response},
+    {"streebog_512_f_multi/4706x4/" STREEBOG_BACKEND,
+     run_streebog_response_multi},
+    {"count_bits", run_count_bits},
+};
+
+#define KERNELS (sizeof(kernels) / sizeof(kernels[0]))
+
+static int setup(void) {
+  for (size_t i = 0; i < N; ++i) {
+    entropy[i] = (uint32_t)(i * 2654435761u);
+  }
+  gen_vector_from(entropy, pi);
+  for (size_t i = 0; i < N; ++i) {
+    sigma[i] = (uint16_t)i;
+  }
+  shuffle(entropy, sigma, sort_buf, N);
+  pack_sigma(sigma, N, packed);
+  for (size_t i = 0; i < SHIPOVNIK_SECRETKEYBYTES; ++i) {
+    sk[i] = (uint8_t)(i * 37 + 11);
+  }
+  for (size_t l = 0; l < SYNDROME_LANES; ++l) {
+    memcpy(lanes_sk[l], sk, SHIPOVNIK_SECRETKEYBYTES);
+    lanes_sk[l][0] ^= (uint8_t)l;
+  }
+  for (size_t l = 0; l < STREEBOG_LANES; ++l) {
+    memset(response[l], (int)l, RESPONSE_BYTES(0));
+  }
+  streebog_512_f(sk, SHIPOVNIK_SECRETKEYBYTES, digest[0]);
+  shifted = h_3_delta_shift(digest[0], GOST512_OUTPUT_BYTES);
+  scratch = NULL == shifted ? NULL
+                            : multiword_number_new(shifted->capacity_words);
+  return NULL == scratch;
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t time_calls(void (*run)(void), size_t iterations) {
+  const uint64_t start = now_ns();
+  for (size_t i = 0; i < iterations; ++i) {
+    run();
+  }
+  return now_ns() - start;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+  const double x = *(const double *)a;
+  const double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+typedef struct {
+  size_t iterations;
+  double median;
+  double min;
+  double cv; ///< coefficient of variation, percent
+} measurement_t;
+
+/**
+ * @brief Measures a kernel: calls it until a run of `iterations` calls lasts
+ * at least `min_ns` (which also warms caches and branch predictors up), makes
+ * `warmup` more untimed runs, then times `repetitions` runs.
+ */
+static void measure(void (*run)(void), uint64_t min_ns, size_t warmup,
+                    size_t repetitions, measurement_t *m) {
+  size_t iterations = 1;
+  while (time_calls(run, iterations) < min_ns) {
+    iterations *= 2;
+  }
+  for (size_t i = 0; i < warmup; ++i) {
+    time_calls(run, iterations);
+  }
+
+  double samples[MAX_REPETITIONS];
+  double sum = 0;
+  for (size_t i = 0; i < repetitions; ++i) {
+    samples[i] = (double)time_calls(run, iterations) / (double)iterations;
+    sum += samples[i];
+  }
+  const double mean = sum / (double)repetitions;
+  double variance = 0;
+  for (size_t i = 0; i < repetitions; ++i) {
+    variance += (samples[i] - mean) * (samples[i] - mean);
+  }
+  variance /= (double)repetitions;
+
+  qsort(samples, repetitions, sizeof(double), compare_doubles);
+  m->iterations = iterations;
+  m->median = samples[repetitions / 2];
+  m->min = samples[0];
+  m->cv = 100.0 * sqrt(variance) / mean;
+}
+
+static int pin(int cpu) {
+#ifdef __linux__
+  if (cpu < 0) {
+    cpu = sched_getcpu();
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (cpu < 0 || sched_setaffinity(0, sizeof(set), &set)) {
+    return -1;
+  }
+  return cpu;
+#else
+  (void)cpu;
+  return -1;
+#endif
+}
+
+/**
+ * @brief Finds the median of a kernel in a baseline file of
+ * `name nanoseconds` lines, `#` starts a comment line.
+ */
+static int baseline_lookup(FILE *f, const char *name, double *ns) {
+  char line[256];
+  char key[NAME_BYTES];
+  rewind(f);
+  while (fgets(line, sizeof(line), f)) {
+    if ('#' != line[0] && 2 == sscanf(line, "%63s %lf", key, ns) &&
+        0 == strcmp(key, name)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void usage(void) {
+  fputs("usage: shipovnik_bench_kernels [-k filter] [-r repetitions] "
+        "[-w warmup] [-m min_ms] [-p cpu] [-s file] [-c file] [-t percent] "
+        "[-e]\n"
+        "  -k  run kernels whose names contain the filter\n"
+        "  -p  pin to the cpu, the current one by default\n"
+        "  -s  save medians as a baseline\n"
+        "  -c  compare with a baseline, fail on a regression over the "
+        "threshold (10%)\n"
+        "  -e  print hardware counters per call\n",
+        stderr);
+}
+
+int main(int argc, char *argv[]) {
+  const char *filter = "";
+  size_t repetitions = 15;
+  size_t warmup = 2;
+  uint64_t min_ns = 10000000;
+  int cpu = -1;
+  const char *save_path = NULL;
+  const char *compare_path = NULL;
+  double threshold = 10;
+  perf_counters_t perf;
+  perf_counters_t *counters = NULL;
+
+  int opt;
+  while (-1 != (opt = getopt(argc, argv, "k:r:w:m:p:s:c:t:e"))) {
+    switch (opt) {
+    case 'k':
+      filter = optarg;
+      break;
+    case 'r':
+      repetitions = strtoul(optarg, NULL, 10);
+      break;
+    case 'w':
+      warmup = strtoul(optarg, NULL, 10);
+      break;
+    case 'm':
+      min_ns = strtoull(optarg, NULL, 10) * 1000000u;
+      break;
+    case 'p':
+      cpu = atoi(optarg);
+      break;
+    case 's':
+      save_path = optarg;
+      break;
+    case 'c':
+      compare_path = optarg;
+      break;
+    case 't':
+      threshold = atof(optarg);
+      break;
+    case 'e':
+      counters = &perf;
+      break;
+    default:
+      usage();
+      return 1;
+    }
+  }
+  if (0 == repetitions || repetitions > MAX_REPETITIONS || optind != argc) {
+    usage();
+    return 1;
+  }
+
+  FILE *save = NULL;
+  FILE *baseline = NULL;
+  if (save_path && NULL == (save = fopen(save_path, "w"))) {
+    perror(save_path);
+    return 1;
+  }
+  if (compare_path && NULL == (baseline = fopen(compare_path, "r"))) {
+    perror(compare_path);
+    return 1;
+  }
+  if (setup()) {
+    fputs("out of memory\n", stderr);
+    return 1;
+  }
+
+  if (counters && 0 == perf_open(counters)) {
+    fputs("warning: performance counters are not available\n", stderr);
+  }
+  cpu = pin(cpu);
+  if (cpu < 0) {
+    fputs("warning: not pinned to a cpu\n", stderr);
+  } else {
+    printf("pinned to cpu %d, streebog backend %s\n", cpu, STREEBOG_BACKEND);
+  }
+  if (save) {
+    fprintf(save, "# shipovnik kernels, median ns per call, backend %s\n",
+            STREEBOG_BACKEND);
+  }
+
+  int regressions = 0;
+  for (size_t k = 0; k < KERNELS; ++k) {
+    if (NULL == strstr(kernels[k].name, filter)) {
+      continue;
+    }
+    measurement_t m;
+    measure(kernels[k].run, min_ns, warmup, repetitions, &m);
+    printf("%-34s %10.1f ns  min %10.1f ns  cv %5.2f%%  x%zu", kernels[k].name,
+           m.median, m.min, m.cv, m.iterations);
+    if (save) {
+      fprintf(save, "%s %.1f\n", kernels[k].name, m.median);
+    }
+    double base;
+    if (baseline && 0 == baseline_lookup(baseline, kernels[k].name, &base)) {
+      const double change = 100.0 * (m.median - base) / base;
+      const int regressed = change > threshold;
+      printf("  %+6.1f%%%s", change, regressed ? "  REGRESSION" : "");
+      regressions += regressed;
+    } else if (baseline) {
+      fputs("  no baseline", stdout);
+    }
+    putchar('\n');
+    if (counters) {
+      // one more run, so that reading the counters does not skew the timing
+      uint64_t before[PERF_EVENTS];
+      uint64_t after[PERF_EVENTS];
+      perf_read(counters, before);
+      time_calls(kernels[k].run, m.iterations);
+      perf_read(counters, after);
+      perf_print(before, after, m.iterations);
+    }
+  }
+
+  if (counters) {
+    perf_close(counters);
+  }
+  if (save) {
+    fclose(save);
+  }
+  if (baseline) {
+    fclose(baseline);
+  }
+  multiword_number_free(scratch);
+  multiword_number_free(shifted);
+  if (regressions) {
+    printf("%d kernel(s) regressed by more than %.1f%%\n", regressions,
+           threshold);
+    return 1;
+  }
+  return 0;
+}
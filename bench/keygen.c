@@ -0,0 +1,86 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "shipovnik.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, size_t count, double seconds) {
+  printf("%-24s %8zu keys %10.3f s %10.1f keys/s\n", name, count, seconds,
+         (double)count / seconds);
+}
+
+int main(int argc, char *argv[]) {
+  // usage: shipovnik_bench_keygen [count [threads]]
+  const size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1024;
+  const size_t threads = argc > 2 ? strtoul(argv[2], NULL, 10) : 0;
+
+  uint8_t *sks = malloc(count * SHIPOVNIK_SECRETKEYBYTES);
+  uint8_t *pks = malloc(count * SHIPOVNIK_PUBLICKEYBYTES);
+  const shipovnik_executor_config_t config = {threads, 0, NULL, 0, -1};
+  shipovnik_executor_t *executor = shipovnik_executor_new(&config);
+  if (NULL == sks || NULL == pks || NULL == executor) {
+    fputs("out of memory\n", stderr);
+    return 1;
+  }
+
+  // warm up caches and fault in the output arrays
+  if (shipovnik_generate_keys_batch(count, sks, pks, executor)) {
+    return 1;
+  }
+
+  double start = now();
+  for (size_t i = 0; i < count; ++i) {
+    shipovnik_generate_keys(sks + i * SHIPOVNIK_SECRETKEYBYTES,
+                            pks + i * SHIPOVNIK_PUBLICKEYBYTES);
+  }
+  report("generate_keys", count, now() - start);
+
+  start = now();
+  if (shipovnik_generate_keys_batch(count, sks, pks, NULL)) {
+    return 1;
+  }
+  report("generate_keys_batch/1", count, now() - start);
+
+  start = now();
+  if (shipovnik_generate_keys_batch(count, sks, pks, executor)) {
+    return 1;
+  }
+  report("generate_keys_batch/pool", count, now() - start);
+
+  shipovnik_executor_free(executor);
+  free(sks);
+  free(pks);
+  return 0;
+}
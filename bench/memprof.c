@@ -0,0 +1,186 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "memprof.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#define PAINT 0xa5
+
+// ASan brings its own allocator, which must not be replaced
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define MEMPROF_SANITIZED
+#endif
+#endif
+#ifdef __SANITIZE_ADDRESS__
+#define MEMPROF_SANITIZED
+#endif
+
+#if defined(__GLIBC__) && !defined(MEMPROF_SANITIZED)
+#define MEMPROF_HEAP
+#endif
+
+#ifdef MEMPROF_HEAP
+
+#include <errno.h>
+#include <malloc.h>
+
+// the allocator of glibc under the replaced functions
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+
+static atomic_llong heap_in_use = 0;
+static atomic_llong heap_peak = 0;
+static atomic_ullong allocations = 0;
+static atomic_ullong allocated_bytes = 0;
+
+static void *allocated(void *ptr, size_t size) {
+  if (NULL == ptr) {
+    return NULL;
+  }
+  atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&allocated_bytes, size, memory_order_relaxed);
+  const long long in_use =
+      atomic_fetch_add_explicit(&heap_in_use, malloc_usable_size(ptr),
+                                memory_order_relaxed) +
+      (long long)malloc_usable_size(ptr);
+  long long peak = atomic_load_explicit(&heap_peak, memory_order_relaxed);
+  while (in_use > peak &&
+         !atomic_compare_exchange_weak_explicit(&heap_peak, &peak, in_use,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+  }
+  return ptr;
+}
+
+static void released(void *ptr) {
+  if (NULL != ptr) {
+    atomic_fetch_sub_explicit(&heap_in_use, malloc_usable_size(ptr),
+                              memory_order_relaxed);
+  }
+}
+
+void *malloc(size_t size) { return allocated(__libc_malloc(size), size); }
+
+void *calloc(size_t count, size_t size) {
+  return allocated(__libc_calloc(count, size), count * size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  // the block may move, so account it as freed and allocated again
+  released(ptr);
+  void *moved = __libc_realloc(ptr, size);
+  if (NULL == moved && NULL != ptr && 0 != size) {
+    // the old block is still allocated
+    atomic_fetch_add_explicit(&heap_in_use, malloc_usable_size(ptr),
+                              memory_order_relaxed);
+    return NULL;
+  }
+  return allocated(moved, size);
+}
+
+void *memalign(size_t alignment, size_t size) {
+  return allocated(__libc_memalign(alignment, size), size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+  return memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size) {
+  void *p = memalign(alignment, size);
+  if (NULL == p) {
+    return ENOMEM;
+  }
+  *ptr = p;
+  return 0;
+}
+
+void free(void *ptr) {
+  released(ptr);
+  __libc_free(ptr);
+}
+
+#endif
+
+// room for the frame of paint_stack between the caller and its area
+#define PAINT_SLACK 4096
+
+// the lowest address of the measured stack, MEMPROF_STACK_BYTES below the
+// frame of memprof_begin, kept as an integer since the area it falls into is
+// gone by the time it is read
+static uintptr_t painted = 0;
+
+#ifdef MEMPROF_HEAP
+static long long heap_start = 0;
+static unsigned long long allocations_start = 0;
+static unsigned long long allocated_bytes_start = 0;
+#endif
+
+// paints below the frame of the caller, deep enough to cover `painted`
+static __attribute__((noinline)) void paint_stack(void) {
+  uint8_t area[MEMPROF_STACK_BYTES + PAINT_SLACK];
+  memset(area, PAINT, sizeof(area));
+  // keep the stores, the area is read after this frame is gone
+  __asm__ volatile("" : : "r"(area) : "memory");
+}
+
+void memprof_begin(void) {
+  painted = (uintptr_t)__builtin_frame_address(0) - MEMPROF_STACK_BYTES;
+  paint_stack();
+#ifdef MEMPROF_HEAP
+  heap_start = atomic_load(&heap_in_use);
+  atomic_store(&heap_peak, heap_start);
+  allocations_start = atomic_load(&allocations);
+  allocated_bytes_start = atomic_load(&allocated_bytes);
+#endif
+}
+
+void memprof_end(memprof_usage_t *usage) {
+  const volatile uint8_t *stack = (const volatile uint8_t *)painted;
+  size_t untouched = 0;
+  while (untouched < MEMPROF_STACK_BYTES && PAINT == stack[untouched]) {
+    ++untouched;
+  }
+  usage->stack_peak = MEMPROF_STACK_BYTES - untouched;
+#ifdef MEMPROF_HEAP
+  usage->heap = 1;
+  usage->heap_peak = atomic_load(&heap_peak) - heap_start;
+  usage->allocations = atomic_load(&allocations) - allocations_start;
+  usage->allocated_bytes =
+      atomic_load(&allocated_bytes) - allocated_bytes_start;
+#else
+  usage->heap = 0;
+  usage->heap_peak = 0;
+  usage->allocations = 0;
+  usage->allocated_bytes = 0;
+#endif
+}
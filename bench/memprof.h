@@ -0,0 +1,60 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// stack painted below the caller by `memprof_begin`
+#define MEMPROF_STACK_BYTES (1u << 20)
+
+/**
+ * @brief Memory used by the code run between `memprof_begin` and
+ * `memprof_end`.
+ */
+typedef struct {
+  int heap;                 ///< `0` if heap usage is not tracked.
+  int64_t heap_peak;        ///< Peak heap in use above that at the start.
+  uint64_t allocations;     ///< Number of allocations.
+  uint64_t allocated_bytes; ///< Bytes requested by the allocations.
+  size_t stack_peak;        ///< Peak stack depth below the caller.
+} memprof_usage_t;
+
+/**
+ * @brief Starts profiling: paints `MEMPROF_STACK_BYTES` of stack below the
+ * caller and resets the heap peak. Heap is tracked by the `malloc` family
+ * replaced in this program, for all the threads.
+ */
+void memprof_begin(void);
+
+/**
+ * @brief Finishes profiling, must be called from the function that called
+ * `memprof_begin`, so that the stack depth is measured from the same point.
+ *
+ * @param[out] usage Memory used since `memprof_begin`.
+ */
+void memprof_end(memprof_usage_t *usage);
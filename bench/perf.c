@@ -0,0 +1,145 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "perf.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char *const names[PERF_EVENTS] = {
+    "cycles",     "instructions", "branch-misses", "l1d-misses",
+    "llc-misses", "dtlb-misses",  "page-faults",   "context-switches"};
+
+const char *perf_event_name(int event) { return names[event]; }
+
+void perf_print(const uint64_t *before, const uint64_t *after, uint64_t ops) {
+  int unavailable = 0;
+  for (int e = 0; e < PERF_EVENTS; ++e) {
+    if (PERF_UNAVAILABLE == before[e] || PERF_UNAVAILABLE == after[e]) {
+      ++unavailable;
+      continue;
+    }
+    printf("  %s %.1f", names[e], (double)(after[e] - before[e]) / ops);
+  }
+  if (PERF_UNAVAILABLE != after[PERF_CYCLES] &&
+      PERF_UNAVAILABLE != after[PERF_INSTRUCTIONS] &&
+      after[PERF_CYCLES] != before[PERF_CYCLES]) {
+    printf("  ipc %.2f",
+           (double)(after[PERF_INSTRUCTIONS] - before[PERF_INSTRUCTIONS]) /
+               (double)(after[PERF_CYCLES] - before[PERF_CYCLES]));
+  }
+  if (unavailable) {
+    printf("  (%d counters unavailable)", unavailable);
+  }
+  putchar('\n');
+}
+
+#ifdef __linux__
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+
+#define CACHE_MISS(cache)                                                      \
+  ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) |                              \
+   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static const struct {
+  uint32_t type;
+  uint64_t config;
+} events[PERF_EVENTS] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, CACHE_MISS(PERF_COUNT_HW_CACHE_L1D)},
+    {PERF_TYPE_HW_CACHE, CACHE_MISS(PERF_COUNT_HW_CACHE_LL)},
+    {PERF_TYPE_HW_CACHE, CACHE_MISS(PERF_COUNT_HW_CACHE_DTLB)},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+};
+
+int perf_open(perf_counters_t *pc) {
+  int opened = 0;
+  for (int e = 0; e < PERF_EVENTS; ++e) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = events[e].type;
+    attr.config = events[e].config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    pc->fds[e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    opened += pc->fds[e] >= 0;
+  }
+  return opened;
+}
+
+void perf_read(const perf_counters_t *pc, uint64_t *values) {
+  for (int e = 0; e < PERF_EVENTS; ++e) {
+    // value, time enabled, time running
+    uint64_t data[3];
+    values[e] = PERF_UNAVAILABLE;
+    if (pc->fds[e] < 0 ||
+        (ssize_t)sizeof(data) != read(pc->fds[e], data, sizeof(data)) ||
+        0 == data[2]) {
+      continue;
+    }
+    values[e] = data[2] == data[1]
+                    ? data[0]
+                    : (uint64_t)((double)data[0] * data[1] / data[2]);
+  }
+}
+
+void perf_close(perf_counters_t *pc) {
+  for (int e = 0; e < PERF_EVENTS; ++e) {
+    if (pc->fds[e] >= 0) {
+      close(pc->fds[e]);
+      pc->fds[e] = -1;
+    }
+  }
+}
+
+#else
+
+int perf_open(perf_counters_t *pc) {
+  for (int e = 0; e < PERF_EVENTS; ++e) {
+    pc->fds[e] = -1;
+  }
+  return 0;
+}
+
+void perf_read(const perf_counters_t *pc, uint64_t *values) {
+  (void)pc;
+  for (int e = 0; e < PERF_EVENTS; ++e) {
+    values[e] = PERF_UNAVAILABLE;
+  }
+}
+
+void perf_close(perf_counters_t *pc) { (void)pc; }
+
+#endif
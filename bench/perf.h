@@ -0,0 +1,91 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+// events counted by `perf_counters_t`
+#define PERF_CYCLES 0
+#define PERF_INSTRUCTIONS 1
+#define PERF_BRANCH_MISSES 2
+#define PERF_L1D_MISSES 3
+#define PERF_LLC_MISSES 4
+#define PERF_DTLB_MISSES 5
+#define PERF_PAGE_FAULTS 6
+#define PERF_CONTEXT_SWITCHES 7
+#define PERF_EVENTS 8
+
+// value of an event that could not be counted
+#define PERF_UNAVAILABLE UINT64_MAX
+
+/**
+ * @brief Hardware and software counters of the calling thread, user space
+ * only. Every event is opened on its own, so the ones the kernel, the CPU or
+ * the container do not provide are skipped.
+ */
+typedef struct {
+  int fds[PERF_EVENTS];
+} perf_counters_t;
+
+/**
+ * @brief Opens the counters.
+ *
+ * @param[out] pc Counters.
+ * @return The number of events that can be counted.
+ */
+int perf_open(perf_counters_t *pc);
+
+/**
+ * @brief Reads the counters, scaled up if the kernel multiplexed them.
+ *
+ * @param[in] pc Counters.
+ * @param[out] values Values indexed by event, `PERF_UNAVAILABLE` for the
+ *   events that are not counted.
+ */
+void perf_read(const perf_counters_t *pc, uint64_t *values);
+
+/**
+ * @brief Closes the counters.
+ *
+ * @param[in] pc Counters.
+ */
+void perf_close(perf_counters_t *pc);
+
+/**
+ * @brief Returns the short name of an event, e.g. `"llc-misses"`.
+ */
+const char *perf_event_name(int event);
+
+/**
+ * @brief Prints the counts per operation between two reads on one line, and
+ * instructions per cycle if both are counted.
+ *
+ * @param[in] before Values read before the operations.
+ * @param[in] after Values read after the operations.
+ * @param[in] ops Number of operations.
+ */
+void perf_print(const uint64_t *before, const uint64_t *after, uint64_t ops);
@@ -0,0 +1,379 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "shipovnik.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_THREADS 1024
+#define BATCH 64
+#define BAR_WIDTH 40
+
+static uint8_t sk[SHIPOVNIK_SECRETKEYBYTES];
+static uint8_t pk[SHIPOVNIK_PUBLICKEYBYTES];
+static uint8_t *msg;
+static size_t msg_len = 32;
+static uint8_t *sig;
+static shipovnik_verify_item_t items[BATCH];
+static int results[BATCH];
+
+typedef struct {
+  shipovnik_executor_t *executor; ///< Pool of the batched modes.
+  uint8_t *sig;                   ///< Output of the thread.
+  uint8_t *sks;                   ///< Output of the thread.
+  uint8_t *pks;                   ///< Output of the thread.
+  double *latencies;
+  size_t calls;
+  size_t capacity;
+  int failed;
+} worker_t;
+
+typedef struct {
+  const char *name;
+  size_t ops_per_call;
+  /// Independent modes run a call on every thread, batched modes run it on
+  /// one thread with an executor of the rest.
+  int batched;
+  int (*call)(worker_t *w);
+} bench_mode_t;
+
+static int call_sign(worker_t *w) {
+  size_t sig_len;
+  shipovnik_sign(sk, msg, msg_len, w->sig, &sig_len);
+  return 0 == sig_len;
+}
+
+static int call_sign_phased(worker_t *w) {
+  size_t sig_len;
+  shipovnik_sign_phased(sk, msg, msg_len, w->sig, &sig_len);
+  return 0 == sig_len;
+}
+
+static int call_verify(worker_t *w) {
+  (void)w;
+  return shipovnik_verify(pk, sig, msg, msg_len);
+}
+
+static int call_keygen(worker_t *w) {
+  shipovnik_generate_keys(w->sks, w->pks);
+  return 0;
+}
+
+static int call_verify_batch(worker_t *w) {
+  return shipovnik_verify_batch(items, BATCH, results, w->executor);
+}
+
+static int call_keygen_batch(worker_t *w) {
+  return shipovnik_generate_keys_batch(BATCH, w->sks, w->pks, w->executor);
+}
+
+static const bench_mode_t modes[] = {
+    {"keygen", 1, 0, call_keygen},
+    {"sign", 1, 0, call_sign},
+    {"sign_phased", 1, 0, call_sign_phased},
+    {"verify", 1, 0, call_verify},
+    {"keygen_batch", BATCH, 1, call_keygen_batch},
+    {"verify_batch", BATCH, 1, call_verify_batch},
+};
+
+#define MODES (sizeof(modes) / sizeof(modes[0]))
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+  const double x = *(const double *)a;
+  const double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+typedef struct {
+  const bench_mode_t *mode;
+  worker_t *worker;
+  pthread_barrier_t *start;
+  double duration;
+} thread_arg_t;
+
+static int record(worker_t *w, double latency) {
+  if (w->calls == w->capacity) {
+    const size_t capacity = w->capacity ? 2 * w->capacity : 64;
+    double *latencies = realloc(w->latencies, capacity * sizeof(double));
+    if (NULL == latencies) {
+      return 1;
+    }
+    w->latencies = latencies;
+    w->capacity = capacity;
+  }
+  w->latencies[w->calls++] = latency;
+  return 0;
+}
+
+static void *run(void *p) {
+  const thread_arg_t *arg = p;
+  worker_t *w = arg->worker;
+  pthread_barrier_wait(arg->start);
+  // warm up, then run until the deadline common for all the threads
+  w->failed |= arg->mode->call(w);
+  pthread_barrier_wait(arg->start);
+  double start = now();
+  const double deadline = start + arg->duration;
+  while (start < deadline && !w->failed) {
+    w->failed |= arg->mode->call(w);
+    const double end = now();
+    w->failed |= record(w, end - start);
+    start = end;
+  }
+  return NULL;
+}
+
+typedef struct {
+  double ops_per_sec;
+  double p50;
+  double p99;
+} point_t;
+
+static int measure(const bench_mode_t *mode, size_t threads, double duration,
+                   point_t *point) {
+  const size_t runners = mode->batched ? 1 : threads;
+  worker_t *workers = calloc(runners, sizeof(worker_t));
+  thread_arg_t *args = calloc(runners, sizeof(thread_arg_t));
+  pthread_t *ids = calloc(runners, sizeof(pthread_t));
+  if (NULL == workers || NULL == args || NULL == ids) {
+    return 1;
+  }
+
+  shipovnik_executor_t *executor = NULL;
+  if (mode->batched && threads > 1) {
+    // the calling thread takes part in the batch too
+    const shipovnik_executor_config_t config = {threads - 1, 0, NULL, 0, -1};
+    if (NULL == (executor = shipovnik_executor_new(&config))) {
+      return 1;
+    }
+  }
+
+  pthread_barrier_t start;
+  pthread_barrier_init(&start, NULL, (unsigned)runners);
+  int failed = 0;
+  for (size_t t = 0; t < runners; ++t) {
+    worker_t *w = &workers[t];
+    w->executor = executor;
+    w->sig = malloc(SHIPOVNIK_SIGBYTES);
+    w->sks = malloc(BATCH * SHIPOVNIK_SECRETKEYBYTES);
+    w->pks = malloc(BATCH * SHIPOVNIK_PUBLICKEYBYTES);
+    failed |= NULL == w->sig || NULL == w->sks || NULL == w->pks;
+    args[t] = (thread_arg_t){mode, w, &start, duration};
+  }
+  for (size_t t = 0; t < runners && !failed; ++t) {
+    failed |= 0 != pthread_create(&ids[t], NULL, run, &args[t]);
+  }
+  if (failed) {
+    return 1;
+  }
+
+  size_t calls = 0;
+  for (size_t t = 0; t < runners; ++t) {
+    pthread_join(ids[t], NULL);
+    failed |= workers[t].failed;
+    calls += workers[t].calls;
+  }
+  double *latencies = malloc((calls ? calls : 1) * sizeof(double));
+  failed |= NULL == latencies || 0 == calls;
+  double elapsed = 0;
+  size_t n = 0;
+  for (size_t t = 0; t < runners && !failed; ++t) {
+    double busy = 0;
+    for (size_t i = 0; i < workers[t].calls; ++i) {
+      busy += workers[t].latencies[i];
+      latencies[n++] = workers[t].latencies[i];
+    }
+    elapsed = busy > elapsed ? busy : elapsed;
+  }
+  if (!failed) {
+    qsort(latencies, calls, sizeof(double), compare_doubles);
+    point->ops_per_sec = (double)(calls * mode->ops_per_call) / elapsed;
+    point->p50 = latencies[(calls - 1) / 2];
+    point->p99 = latencies[(calls - 1) * 99 / 100];
+  }
+
+  free(latencies);
+  for (size_t t = 0; t < runners; ++t) {
+    free(workers[t].latencies);
+    free(workers[t].sig);
+    free(workers[t].sks);
+    free(workers[t].pks);
+  }
+  pthread_barrier_destroy(&start);
+  shipovnik_executor_free(executor);
+  free(ids);
+  free(args);
+  free(workers);
+  return failed;
+}
+
+static size_t parse_threads(const char *s, size_t *threads) {
+  size_t count = 0;
+  while (count < 64 && '\0' != *s) {
+    char *end;
+    threads[count] = strtoul(s, &end, 10);
+    if (end == s || 0 == threads[count] || threads[count] > MAX_THREADS ||
+        (',' != *end && '\0' != *end)) {
+      return 0;
+    }
+    ++count;
+    s = end + (',' == *end);
+  }
+  return count;
+}
+
+static void usage(void) {
+  fputs("usage: shipovnik_bench_scaling [-t threads] [-d seconds] "
+        "[-m mode] [-l msg_len] [-c]\n"
+        "  -t  comma separated thread counts, powers of two up to the number "
+        "of CPUs by default\n"
+        "  -m  keygen, sign, sign_phased, verify, keygen_batch or "
+        "verify_batch, all by default\n"
+        "  -c  print CSV for plotting\n",
+        stderr);
+}
+
+int main(int argc, char *argv[]) {
+  size_t threads[64];
+  size_t thread_counts = 0;
+  double duration = 2;
+  const char *only = NULL;
+  int csv = 0;
+
+  int opt;
+  while (-1 != (opt = getopt(argc, argv, "t:d:m:l:c"))) {
+    switch (opt) {
+    case 't':
+      if (0 == (thread_counts = parse_threads(optarg, threads))) {
+        usage();
+        return 1;
+      }
+      break;
+    case 'd':
+      duration = atof(optarg);
+      break;
+    case 'm':
+      only = optarg;
+      break;
+    case 'l':
+      msg_len = strtoul(optarg, NULL, 10);
+      break;
+    case 'c':
+      csv = 1;
+      break;
+    default:
+      usage();
+      return 1;
+    }
+  }
+  if (duration <= 0 || optind != argc) {
+    usage();
+    return 1;
+  }
+  if (0 == thread_counts) {
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    for (size_t t = 1; t < (size_t)cpus && thread_counts < 63; t *= 2) {
+      threads[thread_counts++] = t;
+    }
+    threads[thread_counts++] = cpus > 0 ? (size_t)cpus : 1;
+  }
+
+  msg = malloc(msg_len ? msg_len : 1);
+  sig = malloc(SHIPOVNIK_SIGBYTES);
+  if (NULL == msg || NULL == sig) {
+    fputs("out of memory\n", stderr);
+    return 1;
+  }
+  memset(msg, 0x5a, msg_len);
+  shipovnik_generate_keys(sk, pk);
+  size_t sig_len;
+  shipovnik_sign(sk, msg, msg_len, sig, &sig_len);
+  for (size_t i = 0; i < BATCH; ++i) {
+    items[i] = (shipovnik_verify_item_t){pk, sig, msg, msg_len};
+  }
+
+  if (csv) {
+    puts("mode,threads,ops_per_sec,p50_ms,p99_ms,speedup,efficiency");
+  }
+  for (size_t m = 0; m < MODES; ++m) {
+    if (only && strcmp(only, modes[m].name)) {
+      continue;
+    }
+    if (!csv) {
+      printf("%s (latency per call of %zu op%s)\n", modes[m].name,
+             modes[m].ops_per_call, modes[m].ops_per_call > 1 ? "s" : "");
+    }
+    double single = 0;
+    double best = 0;
+    point_t points[64];
+    for (size_t i = 0; i < thread_counts; ++i) {
+      if (measure(&modes[m], threads[i], duration, &points[i])) {
+        fprintf(stderr, "%s failed on %zu threads\n", modes[m].name,
+                threads[i]);
+        return 1;
+      }
+      if (0 == i) {
+        // efficiency is relative to linear scaling of the first point
+        single = points[0].ops_per_sec / (double)threads[0];
+      }
+      best = points[i].ops_per_sec > best ? points[i].ops_per_sec : best;
+    }
+    for (size_t i = 0; i < thread_counts; ++i) {
+      const point_t *p = &points[i];
+      const double speedup = p->ops_per_sec / single;
+      const double efficiency = speedup / (double)threads[i];
+      if (csv) {
+        printf("%s,%zu,%.3f,%.3f,%.3f,%.3f,%.3f\n", modes[m].name, threads[i],
+               p->ops_per_sec, p->p50 * 1e3, p->p99 * 1e3, speedup,
+               efficiency);
+        continue;
+      }
+      char bar[BAR_WIDTH + 1];
+      const size_t len = (size_t)(BAR_WIDTH * p->ops_per_sec / best + 0.5);
+      memset(bar, '#', len);
+      bar[len] = '\0';
+      printf("  %4zu threads %10.1f ops/s  p50 %9.3f ms  p99 %9.3f ms  "
+             "efficiency %5.1f%%  %s\n",
+             threads[i], p->ops_per_sec, p->p50 * 1e3, p->p99 * 1e3,
+             100 * efficiency, bar);
+    }
+  }
+
+  free(sig);
+  free(msg);
+  return 0;
+}
@@ -0,0 +1,101 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "shipovnik.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+  const double x = *(const double *)a;
+  const double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static void report(const char *name, double *samples, size_t count) {
+  qsort(samples, count, sizeof(double), compare_doubles);
+  printf("%-16s min %8.1f us  p50 %8.1f us  p99 %8.1f us\n", name,
+         samples[0] * 1e6, samples[count / 2] * 1e6,
+         samples[count * 99 / 100] * 1e6);
+}
+
+int main(int argc, char *argv[]) {
+  // usage: shipovnik_bench_seed [iterations]
+  const size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000;
+  if (0 == count) {
+    return 1;
+  }
+
+  uint8_t seed[SHIPOVNIK_SEEDBYTES];
+  uint8_t sk[SHIPOVNIK_SECRETKEYBYTES];
+  uint8_t pk[SHIPOVNIK_PUBLICKEYBYTES];
+  uint8_t expanded_pk[SHIPOVNIK_PUBLICKEYBYTES];
+  double *samples = malloc(count * sizeof(double));
+  if (NULL == samples) {
+    return 1;
+  }
+
+  shipovnik_generate_seed(seed, pk);
+  shipovnik_expand_seed(seed, sk, expanded_pk);
+  if (memcmp(pk, expanded_pk, SHIPOVNIK_PUBLICKEYBYTES)) {
+    fputs("expanded public key differs\n", stderr);
+    return 1;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    const double start = now();
+    shipovnik_expand_seed(seed, sk, NULL);
+    samples[i] = now() - start;
+  }
+  report("expand sk", samples, count);
+
+  for (size_t i = 0; i < count; ++i) {
+    const double start = now();
+    shipovnik_expand_seed(seed, sk, pk);
+    samples[i] = now() - start;
+  }
+  report("expand sk, pk", samples, count);
+
+  for (size_t i = 0; i < count; ++i) {
+    const double start = now();
+    shipovnik_generate_keys(sk, pk);
+    samples[i] = now() - start;
+  }
+  report("generate_keys", samples, count);
+
+  printf("stored secret key: %d bytes instead of %d\n", SHIPOVNIK_SEEDBYTES,
+         SHIPOVNIK_SECRETKEYBYTES);
+  free(samples);
+  return 0;
+}
@@ -0,0 +1,309 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "gost3411-2012-core.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#else
+#define HAVE_RDTSC 0
+#endif
+
+// every backend is the streebog core built with suffixed function names
+#define DECLARE_BACKEND(suffix)                                                \
+  void GOST34112012Init_##suffix(GOST34112012Context *, const unsigned int);   \
+  void GOST34112012Update_##suffix(GOST34112012Context *,                      \
+                                   const unsigned char *, size_t);             \
+  void GOST34112012Final_##suffix(GOST34112012Context *, unsigned char *);     \
+  void GOST34112012Cleanup_##suffix(GOST34112012Context *);
+
+#define BACKEND(suffix, feature)                                               \
+  {#suffix, feature, GOST34112012Init_##suffix, GOST34112012Update_##suffix,   \
+   GOST34112012Final_##suffix, GOST34112012Cleanup_##suffix}
+
+typedef struct {
+  const char *name;
+  const char *feature; ///< CPU feature required, `NULL` for none.
+  void (*init)(GOST34112012Context *, const unsigned int);
+  void (*update)(GOST34112012Context *, const unsigned char *, size_t);
+  void (*final)(GOST34112012Context *, unsigned char *);
+  void (*cleanup)(GOST34112012Context *);
+} backend_t;
+
+DECLARE_BACKEND(ref)
+#ifdef STREEBOG_HAS_SSE2
+DECLARE_BACKEND(sse2)
+#endif
+#ifdef STREEBOG_HAS_SSE41
+DECLARE_BACKEND(sse41)
+#endif
+
+static const backend_t backends[] = {
+    BACKEND(ref, NULL),
+#ifdef STREEBOG_HAS_SSE2
+    BACKEND(sse2, "sse2"),
+#endif
+#ifdef STREEBOG_HAS_SSE41
+    BACKEND(sse41, "sse4.1"),
+#endif
+};
+
+#define BACKENDS (sizeof(backends) / sizeof(backends[0]))
+
+// lanes hashed in lockstep, as by `streebog_512_f_multi`
+#define LANES 4
+#define BLOCK 64
+#define STREAM_CHUNK 4096
+#define MAX_SIZES 16
+
+// the SSE backends load whole blocks of input with aligned loads
+#define LANE_STRIDE(len) (((len) + 15) & ~(size_t)15)
+
+static int supported(const backend_t *b) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  if (b->feature && 0 == strcmp(b->feature, "sse2")) {
+    return __builtin_cpu_supports("sse2");
+  }
+  if (b->feature && 0 == strcmp(b->feature, "sse4.1")) {
+    return __builtin_cpu_supports("sse4.1");
+  }
+#endif
+  return NULL == b->feature;
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t cycles(void) {
+#if HAVE_RDTSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+typedef enum { ONESHOT, MULTI, STREAM } hash_mode_t;
+
+static const char *mode_names[] = {"oneshot", "multi x4", "stream"};
+
+static GOST34112012Context *align(unsigned char *data) {
+  return (GOST34112012Context *)(((uintptr_t)data + 15) & ~(uintptr_t)15);
+}
+
+/**
+ * @brief Hashes `len` bytes of `buf` once per lane: one message, `LANES`
+ * messages in lockstep a block at a time, or one message in `STREAM_CHUNK`
+ * updates.
+ */
+static void hash(const backend_t *b, hash_mode_t mode, unsigned digest,
+                 const uint8_t *buf, size_t len) {
+  unsigned char data[LANES][sizeof(GOST34112012Context) + 16];
+  uint8_t out[64];
+  GOST34112012Context *ctx = align(data[0]);
+
+  switch (mode) {
+  case ONESHOT:
+    b->init(ctx, digest);
+    b->update(ctx, buf, len);
+    b->final(ctx, out);
+    b->cleanup(ctx);
+    break;
+  case MULTI:
+    for (size_t l = 0; l < LANES; ++l) {
+      b->init(align(data[l]), digest);
+    }
+    for (size_t off = 0; off < len; off += BLOCK) {
+      const size_t chunk = len - off < BLOCK ? len - off : BLOCK;
+      for (size_t l = 0; l < LANES; ++l) {
+        b->update(align(data[l]), buf + l * LANE_STRIDE(len) + off, chunk);
+      }
+    }
+    for (size_t l = 0; l < LANES; ++l) {
+      b->final(align(data[l]), out);
+      b->cleanup(align(data[l]));
+    }
+    break;
+  case STREAM:
+    b->init(ctx, digest);
+    for (size_t off = 0; off < len; off += STREAM_CHUNK) {
+      const size_t chunk =
+          len - off < STREAM_CHUNK ? len - off : STREAM_CHUNK;
+      b->update(ctx, buf + off, chunk);
+    }
+    b->final(ctx, out);
+    b->cleanup(ctx);
+    break;
+  }
+}
+
+typedef struct {
+  double cycles_per_byte;
+  double mib_per_sec;
+} rate_t;
+
+/**
+ * @brief Repeats hashing until it lasts `min_ns`, `repetitions` times, and
+ * takes the fastest repetition.
+ */
+static void measure(const backend_t *b, hash_mode_t mode, unsigned digest,
+                    const uint8_t *buf, size_t len, uint64_t min_ns,
+                    size_t repetitions, rate_t *rate) {
+  const size_t bytes = len * (MULTI == mode ? LANES : 1);
+  size_t iterations = 1;
+  uint64_t best_ns = UINT64_MAX;
+  uint64_t best_cycles = UINT64_MAX;
+
+  for (;;) {
+    const uint64_t start = now_ns();
+    for (size_t i = 0; i < iterations; ++i) {
+      hash(b, mode, digest, buf, len);
+    }
+    if (now_ns() - start >= min_ns) {
+      break;
+    }
+    iterations *= 2;
+  }
+  for (size_t r = 0; r < repetitions; ++r) {
+    const uint64_t start_cycles = cycles();
+    const uint64_t start = now_ns();
+    for (size_t i = 0; i < iterations; ++i) {
+      hash(b, mode, digest, buf, len);
+    }
+    const uint64_t ns = now_ns() - start;
+    const uint64_t c = cycles() - start_cycles;
+    best_ns = ns < best_ns ? ns : best_ns;
+    best_cycles = c < best_cycles ? c : best_cycles;
+  }
+
+  const double total = (double)bytes * (double)iterations;
+  rate->cycles_per_byte = HAVE_RDTSC ? (double)best_cycles / total : -1.0;
+  rate->mib_per_sec = total / (double)best_ns * 1e9 / (1 << 20);
+}
+
+static void usage(void) {
+  fputs("usage: shipovnik_bench_streebog [-b backend] [-s sizes] "
+        "[-l stream_bytes] [-r repetitions] [-m min_ms]\n"
+        "  -s  comma separated message sizes, 362,4706,42048 by default\n"
+        "  -l  size of the streamed message, 64 MiB by default\n",
+        stderr);
+}
+
+int main(int argc, char *argv[]) {
+  const char *only = NULL;
+  size_t sizes[MAX_SIZES] = {362, 4706, 42048};
+  size_t size_count = 3;
+  size_t stream_len = 64u << 20;
+  size_t repetitions = 5;
+  uint64_t min_ns = 20000000;
+
+  int opt;
+  while (-1 != (opt = getopt(argc, argv, "b:s:l:r:m:"))) {
+    switch (opt) {
+    case 'b':
+      only = optarg;
+      break;
+    case 's': {
+      char *s = optarg;
+      for (size_count = 0; size_count < MAX_SIZES && '\0' != *s;) {
+        sizes[size_count++] = strtoul(s, &s, 10);
+        s += ',' == *s;
+      }
+      break;
+    }
+    case 'l':
+      stream_len = strtoul(optarg, NULL, 10);
+      break;
+    case 'r':
+      repetitions = strtoul(optarg, NULL, 10);
+      break;
+    case 'm':
+      min_ns = strtoull(optarg, NULL, 10) * 1000000u;
+      break;
+    default:
+      usage();
+      return 1;
+    }
+  }
+  if (0 == repetitions || 0 == size_count || optind != argc) {
+    usage();
+    return 1;
+  }
+
+  size_t max_len = stream_len;
+  for (size_t i = 0; i < size_count; ++i) {
+    const size_t len = LANES * LANE_STRIDE(sizes[i]);
+    max_len = len > max_len ? len : max_len;
+  }
+  uint8_t *buf = aligned_alloc(16, LANE_STRIDE(max_len ? max_len : 1));
+  if (NULL == buf) {
+    fputs("out of memory\n", stderr);
+    return 1;
+  }
+  for (size_t i = 0; i < max_len; ++i) {
+    buf[i] = (uint8_t)(i * 131 + 17);
+  }
+
+  printf("%-8s %-6s %-9s %10s %12s %10s\n", "backend", "digest", "mode",
+         "bytes", "cycles/byte", "MiB/s");
+  for (size_t k = 0; k < BACKENDS; ++k) {
+    const backend_t *b = &backends[k];
+    if (only && strcmp(only, b->name)) {
+      continue;
+    }
+    if (!supported(b)) {
+      printf("%-8s not supported by this CPU\n", b->name);
+      continue;
+    }
+    for (unsigned digest = 256; digest <= 512; digest += 256) {
+      for (int mode = ONESHOT; mode <= STREAM; ++mode) {
+        const size_t count = STREAM == mode ? 1 : size_count;
+        for (size_t i = 0; i < count; ++i) {
+          const size_t len = STREAM == mode ? stream_len : sizes[i];
+          rate_t rate;
+          measure(b, (hash_mode_t)mode, digest, buf, len, min_ns,
+                  repetitions, &rate);
+          printf("%-8s %-6u %-9s %10zu %12.2f %10.1f\n", b->name, digest,
+                 mode_names[mode], len, rate.cycles_per_byte,
+                 rate.mib_per_sec);
+        }
+      }
+    }
+  }
+
+  free(buf);
+  return 0;
+}
@@ -0,0 +1,112 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "backends.h"
+#include "gost_update.h"
+
+#include "gost3411-2012-core.h"
+
+#include <string.h>
+
+#define DECLARE_BACKEND(suffix)                                                \
+  void GOST34112012Init_##suffix(GOST34112012Context *, const unsigned int);   \
+  void GOST34112012Update_##suffix(GOST34112012Context *,                      \
+                                   const unsigned char *, size_t);             \
+  void GOST34112012Final_##suffix(GOST34112012Context *, unsigned char *);     \
+  void GOST34112012Cleanup_##suffix(GOST34112012Context *);
+
+#define BACKEND(suffix, feature)                                               \
+  {#suffix, feature, GOST34112012Init_##suffix, GOST34112012Update_##suffix,   \
+   GOST34112012Final_##suffix, GOST34112012Cleanup_##suffix}
+
+typedef struct {
+  const char *name;
+  const char *feature; ///< CPU feature required, `NULL` for none.
+  void (*init)(GOST34112012Context *, const unsigned int);
+  void (*update)(GOST34112012Context *, const unsigned char *, size_t);
+  void (*final)(GOST34112012Context *, unsigned char *);
+  void (*cleanup)(GOST34112012Context *);
+} backend_t;
+
+DECLARE_BACKEND(ref)
+#ifdef STREEBOG_HAS_SSE2
+DECLARE_BACKEND(sse2)
+#endif
+#ifdef STREEBOG_HAS_SSE41
+DECLARE_BACKEND(sse41)
+#endif
+
+static const backend_t backends[] = {
+    BACKEND(ref, NULL),
+#ifdef STREEBOG_HAS_SSE2
+    BACKEND(sse2, "sse2"),
+#endif
+#ifdef STREEBOG_HAS_SSE41
+    BACKEND(sse41, "sse4.1"),
+#endif
+};
+
+size_t streebog_backend_count(void) {
+  return sizeof(backends) / sizeof(backends[0]);
+}
+
+const char *streebog_backend_name(size_t backend) {
+  return backends[backend].name;
+}
+
+int streebog_backend_supported(size_t backend) {
+  const backend_t *b = &backends[backend];
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  if (b->feature && 0 == strcmp(b->feature, "sse2")) {
+    return __builtin_cpu_supports("sse2");
+  }
+  if (b->feature && 0 == strcmp(b->feature, "sse4.1")) {
+    return __builtin_cpu_supports("sse4.1");
+  }
+#endif
+  return NULL == b->feature;
+}
+
+void streebog_backend_hash(size_t backend, unsigned digest, const uint8_t *buf,
+                           size_t len, size_t chunk, uint8_t *out) {
+  const backend_t *b = &backends[backend];
+  unsigned char data[sizeof(GOST34112012Context) + 16];
+  GOST34112012Context *ctx =
+      (GOST34112012Context *)(((uintptr_t)data + 15) & ~(uintptr_t)15);
+
+  // through the same alignment handling as streebog_512_update
+  b->init(ctx, digest);
+  if (0 == chunk) {
+    gost_update_aligned(ctx, buf, len, b->update);
+  } else {
+    for (size_t off = 0; off < len; off += chunk) {
+      gost_update_aligned(ctx, buf + off,
+                          len - off < chunk ? len - off : chunk, b->update);
+    }
+  }
+  b->final(ctx, out);
+  b->cleanup(ctx);
+}
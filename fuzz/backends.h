@@ -0,0 +1,63 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Every Streebog backend the compiler targets, built from the streebog core
+// with suffixed function names. Kept apart from the library headers, since
+// the streebog context has a field named as the `N` parameter.
+
+/**
+ * @brief Number of backends, the first one is the reference code.
+ */
+size_t streebog_backend_count(void);
+
+/**
+ * @brief Name of a backend.
+ */
+const char *streebog_backend_name(size_t backend);
+
+/**
+ * @brief Checks that the CPU runs a backend.
+ * @return non-zero if supported
+ */
+int streebog_backend_supported(size_t backend);
+
+/**
+ * @brief Hashes a message with a backend, fed by `gost_update_aligned` as
+ * the library feeds its own backend, so `buf` and `chunk` may be anything.
+ * @param[in] backend backend index
+ * @param[in] digest digest size, 256 or 512
+ * @param[in] buf message
+ * @param[in] len message length
+ * @param[in] chunk size of the updates, 0 for a single update
+ * @param[out] out digest of `digest / 8` bytes
+ */
+void streebog_backend_hash(size_t backend, unsigned digest, const uint8_t *buf,
+                           size_t len, size_t chunk, uint8_t *out);
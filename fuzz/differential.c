@@ -0,0 +1,630 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "backends.h"
+#include "drbg.h"
+#include "genvector.h"
+#include "hash.h"
+#include "multiword.h"
+#include "params.h"
+#include "reference.h"
+#include "shipovnik.h"
+#include "sign.h"
+#include "syndrome.h"
+#include "utils.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// longest message hashed, the multi-buffer hash takes up to 9 of them
+#define MAX_MESSAGE 8192
+// messages start up to this many bytes past a 16 bytes boundary
+#define MAX_SHIFT 15
+#define MAX_MESSAGES (2 * STREEBOG_LANES + 1)
+#define MAX_VECTORS (2 * SYNDROME_LANES + 1)
+#define MAX_WORDS 16
+
+typedef struct {
+  const char *name;
+  uint64_t cases;
+  uint64_t failures;
+} check_t;
+
+enum {
+  CHECK_SYNDROME,
+  CHECK_SYNDROME_BATCH,
+  CHECK_STREEBOG_F,
+  CHECK_STREEBOG_F_MULTI,
+  CHECK_STREEBOG_UPDATE,
+  CHECK_STREEBOG_STATE,
+  CHECK_STREEBOG_BACKENDS,
+  CHECK_APPLY_PERMUTATION,
+  CHECK_CHECK_PERMUTATION,
+  CHECK_PACK_SIGMA,
+  CHECK_UNPACK_SIGMA,
+  CHECK_SHUFFLE,
+  CHECK_COUNT_BITS,
+  CHECK_BITWISE_XOR,
+  CHECK_MULTIWORD,
+  CHECK_CHALLENGE,
+  CHECK_VERIFY,
+  CHECK_DRBG,
+  CHECKS
+};
+
+static check_t checks[CHECKS] = {
+    {"syndrome", 0, 0},
+    {"syndrome_batch", 0, 0},
+    {"streebog_512_f", 0, 0},
+    {"streebog_512_f_multi", 0, 0},
+    {"streebog_512_update", 0, 0},
+    {"streebog_512_set_state", 0, 0},
+    {"streebog backends", 0, 0},
+    {"apply_permutation", 0, 0},
+    {"check_permutation", 0, 0},
+    {"pack_sigma", 0, 0},
+    {"unpack_sigma", 0, 0},
+    {"shuffle", 0, 0},
+    {"count_bits", 0, 0},
+    {"bitwise_xor", 0, 0},
+    {"multiword_number", 0, 0},
+    {"derive_challenge", 0, 0},
+    {"verify entry points", 0, 0},
+    {"drbg_generate", 0, 0},
+};
+
+static uint64_t seed;
+static uint64_t state;
+
+// xorshift64*, reproducible from the seed printed on a failure
+static uint64_t next(void) {
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return state * 0x2545F4914F6CDD1Dull;
+}
+
+static size_t below(size_t bound) { return (size_t)(next() % bound); }
+
+static void fill(uint8_t *buf, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    buf[i] = (uint8_t)next();
+  }
+}
+
+/**
+ * @brief Records a case of a check, prints the first failures.
+ */
+static void expect(int check, int ok, const char *what, size_t param) {
+  check_t *c = &checks[check];
+  ++c->cases;
+  if (!ok && c->failures++ < 5) {
+    fprintf(stderr, "FAIL %s: %s (%zu), seed %" PRIu64 "\n", c->name, what,
+            param, seed);
+  }
+}
+
+// vectors of weight 0, N, and single bits at the H' and identity borders
+static void edge_vector(size_t which, uint8_t *v) {
+  static const size_t bits[] = {0, K - 1, K, N - 1};
+  memset(v, 1 == which ? 0xff : 0, SHIPOVNIK_SECRETKEYBYTES);
+  if (which >= 2) {
+    const size_t bit = bits[which - 2];
+    v[bit / 8] = (uint8_t)(1 << (7 - bit % 8));
+  }
+}
+
+static void check_syndrome(size_t iteration) {
+  uint8_t vs[MAX_VECTORS][SHIPOVNIK_SECRETKEYBYTES];
+  uint8_t ss[MAX_VECTORS][SHIPOVNIK_PUBLICKEYBYTES];
+  uint8_t expected[MAX_VECTORS][SHIPOVNIK_PUBLICKEYBYTES];
+  const uint8_t *vp[MAX_VECTORS];
+  uint8_t *sp[MAX_VECTORS];
+
+  const size_t count = 1 + iteration % MAX_VECTORS;
+  for (size_t i = 0; i < count; ++i) {
+    if (iteration < 6 && 0 == i) {
+      edge_vector(iteration, vs[i]);
+    } else {
+      fill(vs[i], SHIPOVNIK_SECRETKEYBYTES);
+    }
+    ref_syndrome(H_PRIME, vs[i], expected[i]);
+    vp[i] = vs[i];
+    sp[i] = ss[i];
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    syndrome(H_PRIME, vs[i], ss[i]);
+    expect(CHECK_SYNDROME,
+           0 == memcmp(ss[i], expected[i], SHIPOVNIK_PUBLICKEYBYTES),
+           "vector", i);
+  }
+  memset(ss, 0, sizeof(ss));
+  syndrome_batch(H_PRIME, vp, sp, count);
+  for (size_t i = 0; i < count; ++i) {
+    expect(CHECK_SYNDROME_BATCH,
+           0 == memcmp(ss[i], expected[i], SHIPOVNIK_PUBLICKEYBYTES),
+           "vector of a batch", count);
+  }
+}
+
+// lengths around the block borders and of the hashes of the signature
+static size_t message_length(size_t iteration) {
+  static const size_t lengths[] = {0,   1,   63,   64,   65,  127,
+                                   128, 129, 362,  4706, 724, 4096};
+  const size_t edges = sizeof(lengths) / sizeof(lengths[0]);
+  return iteration < edges ? lengths[iteration] : below(MAX_MESSAGE + 1);
+}
+
+static void update_randomly(streebog_ctx_t *ctx, const uint8_t *buf,
+                            size_t len) {
+  for (size_t off = 0; off < len;) {
+    const size_t part = below(len - off + 1);
+    streebog_512_update(ctx, buf + off, part);
+    off += part;
+  }
+}
+
+static void check_streebog(size_t iteration, uint8_t *msgs, uint8_t *shifted) {
+  uint8_t expected[MAX_MESSAGES][GOST512_OUTPUT_BYTES];
+  uint8_t out[MAX_MESSAGES][GOST512_OUTPUT_BYTES];
+  const uint8_t *bufs[MAX_MESSAGES];
+  uint8_t *results[MAX_MESSAGES];
+
+  const size_t len = message_length(iteration);
+  const size_t count = 1 + iteration % MAX_MESSAGES;
+  // the reference hashes the messages in place, the library and the backends
+  // get copies that are mostly misaligned, as a message or a signature part is
+  const size_t shift = iteration % 3 ? 1 + below(MAX_SHIFT) : 0;
+  fill(msgs, MAX_MESSAGES * MAX_MESSAGE);
+  for (size_t i = 0; i < count; ++i) {
+    bufs[i] = shifted + i * MAX_MESSAGE + shift;
+    memcpy((uint8_t *)bufs[i], msgs + i * MAX_MESSAGE, len);
+    results[i] = out[i];
+    streebog_backend_hash(0, 512, msgs + i * MAX_MESSAGE, len, 0, expected[i]);
+    streebog_512_f(bufs[i], len, out[i]);
+    expect(CHECK_STREEBOG_F,
+           0 == memcmp(out[i], expected[i], GOST512_OUTPUT_BYTES), "shift",
+           shift);
+  }
+
+  memset(out, 0, sizeof(out));
+  streebog_512_f_multi(bufs, len, results, count);
+  for (size_t i = 0; i < count; ++i) {
+    expect(CHECK_STREEBOG_F_MULTI,
+           0 == memcmp(out[i], expected[i], GOST512_OUTPUT_BYTES), "length",
+           len);
+  }
+
+  // random splits, with a copy and a midstate taken at a random point
+  const size_t half = below(len + 1);
+  streebog_ctx_t ctx, copy, restored;
+  streebog_state_t midstate;
+  streebog_512_init(&ctx);
+  update_randomly(&ctx, bufs[0], half);
+  streebog_512_copy(&copy, &ctx);
+  streebog_512_get_state(&ctx, &midstate);
+  update_randomly(&ctx, bufs[0] + half, len - half);
+  streebog_512_final(&ctx, out[0]);
+  expect(CHECK_STREEBOG_UPDATE,
+         0 == memcmp(out[0], expected[0], GOST512_OUTPUT_BYTES), "shift",
+         shift);
+
+  int ok = 0 == streebog_512_set_state(&restored, &midstate);
+  streebog_512_update(&copy, bufs[0] + half, len - half);
+  streebog_512_final(&copy, out[1]);
+  streebog_512_update(&restored, bufs[0] + half, len - half);
+  streebog_512_final(&restored, out[2]);
+  ok &= 0 == memcmp(out[1], expected[0], GOST512_OUTPUT_BYTES);
+  ok &= 0 == memcmp(out[2], expected[0], GOST512_OUTPUT_BYTES);
+  expect(CHECK_STREEBOG_STATE, ok, "split at", half);
+
+  // every backend, on the shifted copy, in one update and in updates of any
+  // size that leave the rest of the message at any offset
+  for (size_t b = 1; b < streebog_backend_count(); ++b) {
+    if (!streebog_backend_supported(b)) {
+      continue;
+    }
+    for (unsigned digest = 256; digest <= 512; digest += 256) {
+      uint8_t ref[GOST512_OUTPUT_BYTES];
+      const size_t chunk = iteration % 2 ? 1 + below(4 * GOST_BLOCK_BYTES) : 0;
+      streebog_backend_hash(0, digest, msgs, len, 0, ref);
+      streebog_backend_hash(b, digest, bufs[0], len, chunk, out[0]);
+      expect(CHECK_STREEBOG_BACKENDS, 0 == memcmp(out[0], ref, digest / 8),
+             streebog_backend_name(b), len);
+    }
+  }
+}
+
+static void random_permutation(uint16_t *p) {
+  for (size_t i = 0; i < N; ++i) {
+    p[i] = (uint16_t)i;
+  }
+  for (size_t i = N - 1; i > 0; --i) {
+    const size_t j = below(i + 1);
+    const uint16_t t = p[i];
+    p[i] = p[j];
+    p[j] = t;
+  }
+}
+
+static void check_permutations(size_t iteration) {
+  uint16_t p[N];
+  uint8_t a[SHIPOVNIK_SECRETKEYBYTES];
+  uint8_t out[SHIPOVNIK_SECRETKEYBYTES];
+  uint8_t expected[SHIPOVNIK_SECRETKEYBYTES];
+
+  random_permutation(p);
+  fill(a, sizeof(a));
+  fill(out, sizeof(out));
+  memcpy(expected, out, sizeof(out));
+  // a prefix leaves the bits past it as they are
+  const size_t len = iteration % 2 ? N : below(N + 1);
+  ref_apply_permutation(p, a, expected, len);
+  apply_permutation(p, a, out, len);
+  expect(CHECK_APPLY_PERMUTATION, 0 == memcmp(out, expected, sizeof(out)),
+         "length", len);
+
+  // a valid permutation, a repeated index and indices out of range
+  static const uint16_t bad[] = {N, N + 1, 4095, 0xffff};
+  const size_t i = below(N);
+  switch (iteration % 4) {
+  case 1:
+    p[i] = p[(i + 1 + below(N - 1)) % N];
+    break;
+  case 2:
+    p[i] = bad[below(4)];
+    break;
+  case 3:
+    // an index out of range in place of the missing one
+    p[i] = (uint16_t)(p[i] + N);
+    break;
+  }
+  expect(CHECK_CHECK_PERMUTATION,
+         check_permutation(p) == ref_check_permutation(p), "case",
+         iteration % 4);
+}
+
+static void check_sigma(size_t iteration) {
+  uint16_t in[N];
+  uint16_t out[N];
+  uint16_t expected[N];
+  uint8_t packed[SIGMA_PACKED_BYTES];
+  uint8_t expected_packed[SIGMA_PACKED_BYTES];
+
+  const size_t len = 0 == iteration ? N : 2 * below(N / 2 + 1);
+  for (size_t i = 0; i < len; ++i) {
+    in[i] = (uint16_t)(1 == iteration ? 0xfff : below(1 << SIGMA_BIT_WIDTH));
+  }
+  const size_t bytes = len * SIGMA_BIT_WIDTH / 8;
+  ref_pack_sigma(in, len, expected_packed);
+  int ok = 0 == pack_sigma(in, len, packed);
+  ok &= 0 == memcmp(packed, expected_packed, bytes);
+  ok &= 1 == pack_sigma(in, len | 1, packed);
+  expect(CHECK_PACK_SIGMA, ok, "length", len);
+
+  fill(packed, bytes);
+  ref_unpack_sigma(packed, bytes, expected);
+  ok = 0 == unpack_sigma(packed, bytes, out);
+  ok &= 0 == memcmp(out, expected, len * sizeof(uint16_t));
+  ok &= 1 == unpack_sigma(packed, bytes + 1 + below(2), out);
+  expect(CHECK_UNPACK_SIGMA, ok, "length", bytes);
+}
+
+static void check_shuffle(size_t iteration) {
+  static const size_t lengths[] = {1, 2, 3, 5, 8, 63, 64, 65, 1000, N};
+  const size_t edges = sizeof(lengths) / sizeof(lengths[0]);
+  uint32_t p[N] = {0};
+  uint16_t pi[N] = {0};
+  uint16_t expected[N] = {0};
+  uint64_t buf[N] = {0};
+
+  const size_t len =
+      iteration < edges ? lengths[iteration] : 1 + below(N);
+  // distinct keys, many equal keys, all keys equal
+  const uint32_t range = iteration % 3 == 0   ? UINT32_MAX
+                         : iteration % 3 == 1 ? 4
+                                              : 1;
+  for (size_t i = 0; i < len; ++i) {
+    p[i] = (uint32_t)(range == UINT32_MAX ? next() : next() % range);
+    pi[i] = (uint16_t)next();
+  }
+  memcpy(expected, pi, len * sizeof(uint16_t));
+  if (ref_shuffle(p, expected, len)) {
+    fputs("out of memory\n", stderr);
+    exit(1);
+  }
+  shuffle(p, pi, buf, len);
+  expect(CHECK_SHUFFLE, 0 == memcmp(pi, expected, len * sizeof(uint16_t)),
+         "length", len);
+}
+
+static void check_utils(size_t iteration) {
+  uint8_t x[1024] = {0}, y[1024] = {0}, out[1024] = {0};
+  uint8_t expected[1024] = {0};
+
+  const size_t len = iteration < 2 ? iteration : below(sizeof(x) + 1);
+  fill(x, len);
+  fill(y, len);
+  if (iteration % 4 == 2) {
+    memset(x, 0xff, len);
+  }
+  size_t count = SIZE_MAX;
+  const int ret = count_bits(x, len, &count);
+  // an empty array is rejected
+  expect(CHECK_COUNT_BITS,
+         0 == len ? 1 == ret
+                  : 0 == ret && count == ref_count_bits(x, len),
+         "length", len);
+
+  for (size_t i = 0; i < len; ++i) {
+    expected[i] = x[i] ^ y[i];
+  }
+  bitwise_xor(x, y, (uint32_t)len, out);
+  expect(CHECK_BITWISE_XOR, 0 == memcmp(out, expected, len), "length", len);
+}
+
+// the value of a number in 16 bit limbs, leading zeros dropped
+static size_t to_limbs(const multiword_number_t number, uint16_t *limbs) {
+  size_t len = 2 * number->size_words;
+  for (size_t i = 0; i < number->size_words; ++i) {
+    limbs[2 * i] = (uint16_t)number->words[i];
+    limbs[2 * i + 1] = (uint16_t)(number->words[i] >> 16);
+  }
+  while (len && 0 == limbs[len - 1]) {
+    --len;
+  }
+  return len;
+}
+
+static int same_value(const multiword_number_t number, const uint16_t *limbs,
+                      size_t len) {
+  uint16_t actual[2 * (MAX_WORDS + 1)];
+  while (len && 0 == limbs[len - 1]) {
+    --len;
+  }
+  return to_limbs(number, actual) == len &&
+         0 == memcmp(actual, limbs, len * sizeof(uint16_t));
+}
+
+static void check_multiword(size_t iteration) {
+  uint16_t expected[2 * (MAX_WORDS + 1) + 2];
+  const size_t size = 1 + below(MAX_WORDS);
+  const multiword_number_t x = multiword_number_new(size + 1);
+  const multiword_number_t q = multiword_number_new(size + 1);
+  if (NULL == x || NULL == q) {
+    fputs("out of memory\n", stderr);
+    exit(1);
+  }
+
+  x->size_words = size;
+  for (size_t i = 0; i < size; ++i) {
+    x->words[i] = iteration % 2 ? UINT32_MAX : (word_t)next();
+  }
+  const word_t m =
+      iteration % 3 ? (word_t)next() : 3486784401u; // 3^20, as for h'
+  size_t len = to_limbs(x, expected);
+  ref_multiply(expected, &len, m);
+  int ok = 1 == multiword_number_multiply_by_word(x, m);
+  ok &= same_value(x, expected, len);
+  expect(CHECK_MULTIWORD, ok, "multiply, words", size);
+
+  word_t rem = UINT32_MAX;
+  const uint32_t expected_rem = ref_div_3(expected, len);
+  ok = 1 == multiword_number_div_3(x, q, &rem);
+  ok &= rem == expected_rem && same_value(q, expected, len);
+  expect(CHECK_MULTIWORD, ok, "divide, words", x->size_words);
+
+  multiword_number_free(q);
+  multiword_number_free(x);
+}
+
+static void check_challenge(size_t iteration) {
+  uint8_t h[GOST512_OUTPUT_BYTES];
+  uint8_t b[DELTA];
+  uint8_t expected[DELTA];
+
+  // the smallest, the largest and a single bit hash
+  switch (iteration) {
+  case 0:
+    memset(h, 0, sizeof(h));
+    break;
+  case 1:
+    memset(h, 0xff, sizeof(h));
+    break;
+  case 2:
+    memset(h, 0, sizeof(h));
+    h[0] = 0x80;
+    break;
+  case 3:
+    memset(h, 0, sizeof(h));
+    h[sizeof(h) - 1] = 1;
+    break;
+  default:
+    fill(h, sizeof(h));
+  }
+  ref_challenge(h, expected);
+  memset(b, 0xff, sizeof(b));
+  const int ret = derive_challenge(h, b);
+  expect(CHECK_CHALLENGE, 0 == ret && 0 == memcmp(b, expected, DELTA),
+         "case", iteration);
+}
+
+// a signature and a message at odd offsets through every verify entry point
+static void check_verify(size_t iteration) {
+  static uint8_t sk[SHIPOVNIK_SECRETKEYBYTES], pk[SHIPOVNIK_PUBLICKEYBYTES];
+  static uint8_t sig_buf[SHIPOVNIK_SIGBYTES + 16], msg_buf[256 + 16];
+
+  // signing takes most of the time of an iteration
+  if (iteration % 16) {
+    return;
+  }
+  shipovnik_generate_keys(sk, pk);
+  uint8_t *sig = sig_buf + 1 + below(15);
+  uint8_t *msg = msg_buf + 1 + below(15);
+  const size_t msg_len = below(257);
+  size_t sig_len = 0;
+  fill(msg, msg_len);
+  shipovnik_sign(sk, msg, msg_len, sig, &sig_len);
+
+  int ok = 0 == shipovnik_verify(pk, sig, msg, msg_len);
+  ok &= SHIPOVNIK_VERIFY_OK == shipovnik_verify_checked(pk, sig, sig_len, msg,
+                                                        msg_len, SIZE_MAX);
+  const shipovnik_verify_item_t item = {pk, sig, msg, msg_len};
+  int result = 1;
+  ok &= 0 == shipovnik_verify_batch(&item, 1, &result, NULL) && 0 == result;
+
+  shipovnik_verify_stream_t *stream = shipovnik_verify_stream_begin(pk);
+  if (NULL == stream) {
+    fputs("out of memory\n", stderr);
+    exit(1);
+  }
+  shipovnik_verify_stream_message(stream, msg, msg_len);
+  for (size_t off = 0; off < sig_len;) {
+    const size_t part = 1 + below(sig_len - off);
+    shipovnik_verify_stream_signature(stream, sig + off, part);
+    off += part;
+  }
+  ok &= 0 == shipovnik_verify_stream_finish(stream);
+
+  shipovnik_message_t *absorbed = shipovnik_message_new();
+  if (NULL == absorbed) {
+    fputs("out of memory\n", stderr);
+    exit(1);
+  }
+  const size_t half = below(msg_len + 1);
+  shipovnik_message_update(absorbed, msg, half);
+  shipovnik_message_update(absorbed, msg + half, msg_len - half);
+  ok &= 0 == shipovnik_verify_absorbed(pk, sig, absorbed);
+  shipovnik_message_free(absorbed);
+  expect(CHECK_VERIFY, ok, "message length", msg_len);
+}
+
+// output of any length is a prefix of the blocks of the counter mode
+static void check_drbg(size_t iteration) {
+  static const size_t lengths[] = {0, 1, 10, 63, 64, 65, 255, 256, 257};
+  const size_t edges = sizeof(lengths) / sizeof(lengths[0]);
+  enum { MAX_BLOCKS = 2 * STREEBOG_LANES + 3 };
+  uint8_t seed_bytes[DRBG_SEED_BYTES];
+  uint8_t out[MAX_BLOCKS * GOST512_OUTPUT_BYTES];
+  uint8_t expected[MAX_BLOCKS * GOST512_OUTPUT_BYTES];
+  uint8_t input[DRBG_SEED_BYTES + 8];
+
+  const size_t len =
+      iteration < edges ? lengths[iteration] : below(sizeof(out) + 1);
+  const size_t blocks =
+      (len + GOST512_OUTPUT_BYTES - 1) / GOST512_OUTPUT_BYTES;
+  fill(seed_bytes, sizeof(seed_bytes));
+  memcpy(input, seed_bytes, DRBG_SEED_BYTES);
+  for (size_t b = 0; b < blocks; ++b) {
+    for (size_t i = 0; i < 8; ++i) {
+      input[DRBG_SEED_BYTES + i] = (uint8_t)((uint64_t)b >> (56 - 8 * i));
+    }
+    streebog_backend_hash(0, 512, input, sizeof(input), 0,
+                          expected + b * GOST512_OUTPUT_BYTES);
+  }
+
+  drbg_t drbg;
+  drbg_init(&drbg, seed_bytes);
+  memset(out, 0, sizeof(out));
+  drbg_generate(&drbg, out, len);
+  expect(CHECK_DRBG,
+         0 == memcmp(out, expected, len) && blocks == drbg.counter,
+         "length", len);
+}
+
+static void usage(void) {
+  fputs("usage: shipovnik_differential [-i iterations] [-s seed]\n", stderr);
+}
+
+int main(int argc, char *argv[]) {
+  size_t iterations = 50;
+  seed = (uint64_t)time(NULL);
+
+  int opt;
+  while (-1 != (opt = getopt(argc, argv, "i:s:"))) {
+    switch (opt) {
+    case 'i':
+      iterations = strtoul(optarg, NULL, 10);
+      break;
+    case 's':
+      seed = strtoull(optarg, NULL, 10);
+      break;
+    default:
+      usage();
+      return 1;
+    }
+  }
+  if (optind != argc) {
+    usage();
+    return 1;
+  }
+  state = seed ? seed : 1;
+
+  uint8_t *msgs = malloc(MAX_MESSAGES * MAX_MESSAGE);
+  uint8_t *shifted = malloc(MAX_MESSAGES * MAX_MESSAGE + MAX_SHIFT);
+  if (NULL == msgs || NULL == shifted) {
+    fputs("out of memory\n", stderr);
+    free(shifted);
+    free(msgs);
+    return 1;
+  }
+
+  printf("seed %" PRIu64 ", %zu iterations, streebog backends:", seed,
+         iterations);
+  for (size_t b = 0; b < streebog_backend_count(); ++b) {
+    printf(" %s%s", streebog_backend_name(b),
+           streebog_backend_supported(b) ? "" : " (unsupported)");
+  }
+  putchar('\n');
+
+  for (size_t i = 0; i < iterations; ++i) {
+    check_syndrome(i);
+    check_streebog(i, msgs, shifted);
+    check_permutations(i);
+    check_sigma(i);
+    check_shuffle(i);
+    check_utils(i);
+    check_multiword(i);
+    check_challenge(i);
+    check_verify(i);
+    check_drbg(i);
+  }
+  free(shifted);
+  free(msgs);
+
+  uint64_t failures = 0;
+  for (int c = 0; c < CHECKS; ++c) {
+    printf("%-24s %8" PRIu64 " cases  %s\n", checks[c].name, checks[c].cases,
+           checks[c].failures ? "FAILED" : "ok");
+    failures += checks[c].failures;
+  }
+  return failures ? 1 : 0;
+}
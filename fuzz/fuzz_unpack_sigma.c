@@ -0,0 +1,68 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "params.h"
+#include "reference.h"
+#include "sign.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The input is a packed sigma of any length. It must unpack as the reference
+// does, pack back to the same bytes, and a full sigma must be accepted as a
+// permutation exactly when the reference accepts it.
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  static uint16_t sigma[2 * N];
+  static uint16_t expected[2 * N];
+  static uint8_t packed[2 * SIGMA_PACKED_BYTES];
+
+  if (size > sizeof(packed)) {
+    return 0;
+  }
+  if (size % 3) {
+    if (1 != unpack_sigma(data, size, sigma)) {
+      abort();
+    }
+    return 0;
+  }
+
+  const size_t count = size * 8 / SIGMA_BIT_WIDTH;
+  ref_unpack_sigma(data, size, expected);
+  if (0 != unpack_sigma(data, size, sigma) ||
+      0 != memcmp(sigma, expected, count * sizeof(uint16_t))) {
+    abort();
+  }
+  if (0 != pack_sigma(sigma, count, packed) ||
+      0 != memcmp(packed, data, size)) {
+    abort();
+  }
+  if (SIGMA_PACKED_BYTES == size &&
+      check_permutation(sigma) != ref_check_permutation(sigma)) {
+    abort();
+  }
+  return 0;
+}
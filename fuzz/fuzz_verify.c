@@ -0,0 +1,57 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "shipovnik.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The input is a public key followed by a signature of a fixed message. The
+// signature is zero padded to the largest size for `shipovnik_verify`, which
+// takes no signature length, and is passed as is to
+// `shipovnik_verify_checked`. Both must agree on valid signatures.
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  static const uint8_t msg[] = "shipovnik fuzz";
+  static uint8_t sig[SHIPOVNIK_SIGBYTES];
+
+  if (size < SHIPOVNIK_PUBLICKEYBYTES ||
+      size - SHIPOVNIK_PUBLICKEYBYTES > SHIPOVNIK_SIGBYTES) {
+    return 0;
+  }
+  const uint8_t *pk = data;
+  const size_t sig_len = size - SHIPOVNIK_PUBLICKEYBYTES;
+  memset(sig, 0, sizeof(sig));
+  memcpy(sig, data + SHIPOVNIK_PUBLICKEYBYTES, sig_len);
+
+  const int valid = 0 == shipovnik_verify(pk, sig, msg, sizeof(msg));
+  const int checked = shipovnik_verify_checked(
+      pk, sig, sig_len, msg, sizeof(msg), SIZE_MAX);
+  if (0 == checked && !valid) {
+    abort();
+  }
+  return 0;
+}
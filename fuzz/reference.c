@@ -0,0 +1,167 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "reference.h"
+#include "params.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define PRIME_COLUMNS (N - K)
+
+static int get_bit(const uint8_t *a, size_t i) {
+  return (a[i / 8] >> (7 - i % 8)) & 1;
+}
+
+static void set_bit(uint8_t *a, size_t i, int bit) {
+  a[i / 8] &= ~(1 << (7 - i % 8));
+  a[i / 8] |= bit << (7 - i % 8);
+}
+
+void ref_syndrome(const uint8_t *H_prime, const uint8_t *v, uint8_t *s) {
+  for (size_t i = 0; i < K; ++i) {
+    const uint8_t *row = H_prime + i * (PRIME_COLUMNS / 8);
+    int bit = get_bit(v, PRIME_COLUMNS + i); // the identity part
+    for (size_t j = 0; j < PRIME_COLUMNS; ++j) {
+      bit ^= get_bit(row, j) & get_bit(v, j);
+    }
+    set_bit(s, i, bit);
+  }
+}
+
+void ref_apply_permutation(const uint16_t *p, const uint8_t *a, uint8_t *out,
+                           size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    set_bit(out, i, get_bit(a, p[i]));
+  }
+}
+
+int ref_check_permutation(const uint16_t *p) {
+  uint8_t seen[N] = {0};
+  for (size_t i = 0; i < N; ++i) {
+    if (p[i] >= N || seen[p[i]]) {
+      return 1;
+    }
+    seen[p[i]] = 1;
+  }
+  return 0;
+}
+
+void ref_pack_sigma(const uint16_t *in, size_t in_len, uint8_t *out) {
+  memset(out, 0, in_len * SIGMA_BIT_WIDTH / 8);
+  for (size_t i = 0; i < in_len; ++i) {
+    for (size_t k = 0; k < SIGMA_BIT_WIDTH; ++k) {
+      const int bit = (in[i] >> (SIGMA_BIT_WIDTH - 1 - k)) & 1;
+      set_bit(out, i * SIGMA_BIT_WIDTH + k, bit);
+    }
+  }
+}
+
+void ref_unpack_sigma(const uint8_t *in, size_t in_len, uint16_t *out) {
+  for (size_t i = 0; i < in_len * 8 / SIGMA_BIT_WIDTH; ++i) {
+    out[i] = 0;
+    for (size_t k = 0; k < SIGMA_BIT_WIDTH; ++k) {
+      out[i] = (out[i] << 1) | get_bit(in, i * SIGMA_BIT_WIDTH + k);
+    }
+  }
+}
+
+static int compare_keys(const void *a, const void *b) {
+  const uint64_t x = *(const uint64_t *)a;
+  const uint64_t y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+int ref_shuffle(const uint32_t *p, uint16_t *pi, size_t len) {
+  uint64_t *keys = malloc(len * sizeof(uint64_t) + 1);
+  if (NULL == keys) {
+    return 1;
+  }
+  for (size_t i = 0; i < len; ++i) {
+    keys[i] = ((uint64_t)p[i] << 16) | pi[i];
+  }
+  qsort(keys, len, sizeof(uint64_t), compare_keys);
+  for (size_t i = 0; i < len; ++i) {
+    pi[i] = (uint16_t)keys[i];
+  }
+  free(keys);
+  return 0;
+}
+
+size_t ref_count_bits(const uint8_t *src, size_t len) {
+  size_t count = 0;
+  for (size_t i = 0; i < 8 * len; ++i) {
+    count += get_bit(src, i);
+  }
+  return count;
+}
+
+// limbs of h, of 3^DELTA < 2^(2 * DELTA) and the room for the carries
+#define CHALLENGE_LIMBS (GOST512_OUTPUT_BYTES / 2 + DELTA / 8 + 4)
+
+void ref_challenge(const uint8_t *h, uint8_t *b) {
+  uint16_t x[CHALLENGE_LIMBS] = {0};
+  size_t len = GOST512_OUTPUT_BYTES / 2;
+  for (size_t i = 0; i < len; ++i) {
+    const uint8_t *limb = h + GOST512_OUTPUT_BYTES - 2 * (i + 1);
+    x[i] = (uint16_t)((limb[0] << 8) | limb[1]);
+  }
+  for (size_t i = 0; i < DELTA; ++i) {
+    ref_multiply(x, &len, 3);
+  }
+
+  // >> 512
+  const size_t shift = 512 / 16;
+  len = len > shift ? len - shift : 0;
+  memmove(x, x + shift, len * sizeof(uint16_t));
+
+  for (size_t i = DELTA; i-- > 0;) {
+    b[i] = (uint8_t)ref_div_3(x, len);
+  }
+}
+
+void ref_multiply(uint16_t *limbs, size_t *len, uint32_t m) {
+  uint64_t carry = 0;
+  for (size_t i = 0; i < *len; ++i) {
+    carry += (uint64_t)limbs[i] * m;
+    limbs[i] = (uint16_t)carry;
+    carry >>= 16;
+  }
+  while (carry) {
+    limbs[(*len)++] = (uint16_t)carry;
+    carry >>= 16;
+  }
+}
+
+uint32_t ref_div_3(uint16_t *limbs, size_t len) {
+  uint32_t rem = 0;
+  for (size_t i = len; i-- > 0;) {
+    const uint32_t cur = (rem << 16) | limbs[i];
+    limbs[i] = (uint16_t)(cur / 3);
+    rem = cur % 3;
+  }
+  return rem;
+}
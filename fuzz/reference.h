@@ -0,0 +1,101 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Straightforward implementations of the kernels, written from the
+// specification one bit or one digit at a time. They are slow on purpose and
+// share no code with the library, so the library may be checked against them.
+
+/**
+ * @brief Computes the syndrome of `v` bit by bit: bit `i` is the parity of
+ * row `i` of H = [H' | I] and `v`.
+ * @param[in] H_prime The H' matrix.
+ * @param[in] v vector of size `SHIPOVNIK_SECRETKEYBYTES`
+ * @param[out] s syndrome of size `SHIPOVNIK_PUBLICKEYBYTES`
+ */
+void ref_syndrome(const uint8_t *H_prime, const uint8_t *v, uint8_t *s);
+
+/**
+ * @brief Sets bit `i` of `out` to bit `p[i]` of `a`, bits are numbered from
+ * the most significant bit of the first byte. Bits of `out` past `len` are
+ * left as they are.
+ */
+void ref_apply_permutation(const uint16_t *p, const uint8_t *a, uint8_t *out,
+                           size_t len);
+
+/**
+ * @brief Checks that `p` of size `N` holds every index of `[0, N)` once.
+ * @return 0 if `p` is a permutation, otherwise 1
+ */
+int ref_check_permutation(const uint16_t *p);
+
+/**
+ * @brief Writes `in_len` indices as 12 bit big endian fields.
+ */
+void ref_pack_sigma(const uint16_t *in, size_t in_len, uint8_t *out);
+
+/**
+ * @brief Reads `in_len * 8 / 12` indices from 12 bit big endian fields.
+ */
+void ref_unpack_sigma(const uint8_t *in, size_t in_len, uint16_t *out);
+
+/**
+ * @brief Sorts `pi` by the keys `p`, ties are broken by the values of `pi`,
+ * the order the sorting network of `shuffle` gives.
+ * @return 0 if Ok, 1 if out of memory
+ */
+int ref_shuffle(const uint32_t *p, uint16_t *pi, size_t len);
+
+/**
+ * @brief Counts bits set in `src` one bit at a time.
+ */
+size_t ref_count_bits(const uint8_t *src, size_t len);
+
+/**
+ * @brief Computes the challenge of the hash `h` digit by digit: the `DELTA`
+ * ternary digits of `(h * 3^DELTA) >> 512`, most significant first, where `h`
+ * is read as a big endian number.
+ * @param[in] h hash of size `GOST512_OUTPUT_BYTES`
+ * @param[out] b challenge of size `DELTA`
+ */
+void ref_challenge(const uint8_t *h, uint8_t *b);
+
+/**
+ * @brief Multiplies a number of 16 bit little endian limbs by `m`.
+ * @param[in,out] limbs number, must have room for two more limbs
+ * @param[in,out] len number of limbs
+ */
+void ref_multiply(uint16_t *limbs, size_t *len, uint32_t m);
+
+/**
+ * @brief Divides a number of 16 bit little endian limbs by 3 in place.
+ * @return the remainder
+ */
+uint32_t ref_div_3(uint16_t *limbs, size_t len);
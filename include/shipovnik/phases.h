@@ -0,0 +1,42 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+/**
+ * @brief Phases measured by the instrumentation. Operations include the
+ * phases they run, so their time is not a sum of the other phases.
+ */
+#define SHIPOVNIK_PHASE_KEYGEN 0    ///< `shipovnik_generate_keys`.
+#define SHIPOVNIK_PHASE_SIGN 1      ///< `shipovnik_sign`.
+#define SHIPOVNIK_PHASE_VERIFY 2    ///< `shipovnik_verify`.
+#define SHIPOVNIK_PHASE_ENTROPY 3   ///< Reads of the entropy source.
+#define SHIPOVNIK_PHASE_SHUFFLE 4   ///< Shuffles by the sorting network.
+#define SHIPOVNIK_PHASE_SYNDROME 5  ///< Syndromes, single and batched.
+#define SHIPOVNIK_PHASE_HASH 6      ///< Streebog updates and digests.
+#define SHIPOVNIK_PHASE_CHALLENGE 7 ///< Challenges derived from hashes.
+#define SHIPOVNIK_PHASE_RESPONSE 8  ///< Responses of the rounds.
+#define SHIPOVNIK_PHASES 9
@@ -27,6 +27,7 @@
 #pragma once
 
 #include "params.h"
+#include "phases.h"
 
 #include <stddef.h>
 #include <stdint.h>
@@ -40,6 +41,58 @@
  */
 void shipovnik_generate_keys(uint8_t *sk, uint8_t *pk);
 
+/**
+ * @brief Thread pool used by the parallel entry points of the library.
+ */
+typedef struct shipovnik_executor_st shipovnik_executor_t;
+
+/**
+ * @brief Generates many random key pairs. Keys are generated in groups that
+ * share one read of the entropy source and one pass over H' for their public
+ * keys, groups are spread over the executor.
+ *
+ * @param[in] count Number of key pairs.
+ * @param[out] sks Contiguous array to receive secret keys, of size
+ *   `count * SHIPOVNIK_SECRETKEYBYTES`.
+ * @param[out] pks Contiguous array to receive public keys, of size
+ *   `count * SHIPOVNIK_PUBLICKEYBYTES`.
+ * @param[in] executor Executor to spread the work over, the calling thread
+ *   takes part too. `NULL` means the calling thread only.
+ * @return `0` on success, otherwise non-zero value.
+ */
+int shipovnik_generate_keys_batch(size_t count, uint8_t *sks, uint8_t *pks,
+                                  shipovnik_executor_t *executor);
+
+/**
+ * @brief Size of a seed a secret key is expanded from.
+ */
+#define SHIPOVNIK_SEEDBYTES 32
+
+/**
+ * @brief Generates a random key pair whose secret key is stored as a seed of
+ * `SHIPOVNIK_SEEDBYTES` and expanded by `shipovnik_expand_seed` when needed.
+ *
+ * @param[out] seed Contiguous array to receive the seed, of size
+ *   `SHIPOVNIK_SEEDBYTES`.
+ * @param[out] pk Contiguous array to receive public key, of size
+ *   `SHIPOVNIK_PUBLICKEYBYTES`.
+ */
+void shipovnik_generate_seed(uint8_t *seed, uint8_t *pk);
+
+/**
+ * @brief Expands a seed into the key pair. The seed is stretched by a
+ * Streebog-512 counter mode generator into as much entropy as
+ * `shipovnik_generate_keys` draws from the entropy source, and the secret
+ * vector is sampled from it the same way.
+ *
+ * @param[in] seed Seed, the contiguous array of size `SHIPOVNIK_SEEDBYTES`.
+ * @param[out] sk Contiguous array to receive secret key, of size
+ *   `SHIPOVNIK_SECRETKEYBYTES`.
+ * @param[out] pk Contiguous array to receive public key, of size
+ *   `SHIPOVNIK_PUBLICKEYBYTES`, or `NULL` if it is not needed.
+ */
+void shipovnik_expand_seed(const uint8_t *seed, uint8_t *sk, uint8_t *pk);
+
 /**
  * @brief Generates signature for given message according to secret key.
  *
@@ -54,6 +107,52 @@ void shipovnik_generate_keys(uint8_t *sk, uint8_t *pk);
 void shipovnik_sign(const uint8_t *sk, const uint8_t *msg, size_t msg_len,
                     uint8_t *sig, size_t *sig_len);
 
+/**
+ * @brief Generates signature for given message according to secret key, same
+ * as `shipovnik_sign`, but every phase of the algorithm is run over a block of
+ * rounds before the next one: entropy, shuffles, syndromes and each of the
+ * commitment hashes. Consumes entropy in the same order, so the signature is
+ * identical to that of `shipovnik_sign`.
+ *
+ * @param[in] sk Secret key, the contiguous array of size
+ *   `SHIPOVNIK_SECRETKEYBYTES`.
+ * @param[in] msg Message to generate signature of, the contiguous array.
+ * @param[in] msg_len The length of a message in bytes.
+ * @param[out] sig Contiguous array to receive signature, of size
+ *   `SHIPOVNIK_SIGBYTES`.
+ * @param[out] sig_len The result signature size, `0` on failure.
+ */
+void shipovnik_sign_phased(const uint8_t *sk, const uint8_t *msg,
+                           size_t msg_len, uint8_t *sig, size_t *sig_len);
+
+/**
+ * @brief Destination of a signature generated by `shipovnik_sign_to`.
+ */
+typedef struct shipovnik_sign_sink_st {
+  void *ctx; ///< Destination, passed to the callback.
+  /// Writes the next `len` bytes of the signature. Returns `0` on success,
+  /// otherwise signature generation is stopped.
+  int (*write)(void *ctx, const uint8_t *buf, size_t len);
+} shipovnik_sign_sink_t;
+
+/**
+ * @brief Generates signature for given message according to secret key, same
+ * as `shipovnik_sign`, but writes it to a sink instead of a buffer: the
+ * commitments in one call as soon as all of them are computed, then every
+ * response in a call of its own. Consumes entropy in the same order, so the
+ * signature is identical to that of `shipovnik_sign`.
+ *
+ * @param[in] sk Secret key, the contiguous array of size
+ *   `SHIPOVNIK_SECRETKEYBYTES`.
+ * @param[in] msg Message to generate signature of, the contiguous array.
+ * @param[in] msg_len The length of a message in bytes.
+ * @param[in] sink Destination of the signature.
+ * @param[out] sig_len The number of signature bytes written.
+ * @return `0` if the whole signature is written, otherwise non-zero value.
+ */
+int shipovnik_sign_to(const uint8_t *sk, const uint8_t *msg, size_t msg_len,
+                      const shipovnik_sign_sink_t *sink, size_t *sig_len);
+
 /**
  * @brief Verifies that given signature is the signature of given message.
  *
@@ -68,3 +167,885 @@ void shipovnik_sign(const uint8_t *sk, const uint8_t *msg, size_t msg_len,
  */
 int shipovnik_verify(const uint8_t *pk, const uint8_t *sig, const uint8_t *msg,
                      size_t msg_len);
+
+/**
+ * @brief Results of `shipovnik_verify_checked`.
+ */
+#define SHIPOVNIK_VERIFY_OK 0
+/// A response does not match its commitment.
+#define SHIPOVNIK_VERIFY_MISMATCH 1
+/// The signature length is not a length of any signature.
+#define SHIPOVNIK_VERIFY_BAD_LENGTH 2
+/// A response reveals indices that are not a permutation.
+#define SHIPOVNIK_VERIFY_BAD_PERMUTATION 3
+/// A response reveals a vector of wrong weight.
+#define SHIPOVNIK_VERIFY_BAD_WEIGHT 4
+/// Verification would cost more than the budget.
+#define SHIPOVNIK_VERIFY_OVER_BUDGET 5
+/// The challenge can not be derived, e.g. memory can not be allocated.
+#define SHIPOVNIK_VERIFY_ERROR 6
+/// An inclusion proof does not lead from the document to a tree root.
+#define SHIPOVNIK_VERIFY_BAD_PROOF 7
+
+/**
+ * @brief Estimates the cost of `shipovnik_verify_checked`.
+ *
+ * @param[in] sig_len The length of a signature in bytes.
+ * @param[in] msg_len The length of a message in bytes.
+ * @return The number of bytes hashed plus the bytes of H' read for
+ *   syndromes, or `SIZE_MAX` if `sig_len` is not a length of any signature.
+ */
+size_t shipovnik_verify_cost(size_t sig_len, size_t msg_len);
+
+/**
+ * @brief Verifies an untrusted signature, doing cheap checks first.
+ *
+ * The signature length and the cost are checked before anything is hashed.
+ * Once the challenge is derived, responses of all the rounds are checked to
+ * reveal permutations and vectors of weight `W`, and only then the
+ * commitments are recomputed.
+ *
+ * @param[in] pk Public key, the contiguous array of size
+ *   `SHIPOVNIK_PUBLICKEYBYTES`.
+ * @param[in] sig Signature, the contiguous array.
+ * @param[in] sig_len The length of a signature in bytes, as returned by
+ *   `shipovnik_sign`.
+ * @param[in] msg Message to verify signature of, the contiguous array.
+ * @param[in] msg_len The length of a message in bytes.
+ * @param[in] budget Maximal cost, see `shipovnik_verify_cost`. `SIZE_MAX`
+ *   means no limit.
+ * @return `SHIPOVNIK_VERIFY_OK` if given signature is the signature of given
+ *   message, otherwise the reason of rejection.
+ */
+int shipovnik_verify_checked(const uint8_t *pk, const uint8_t *sig,
+                             size_t sig_len, const uint8_t *msg,
+                             size_t msg_len, size_t budget);
+
+/**
+ * @brief Task run by an executor.
+ */
+typedef void (*shipovnik_task_fn)(void *arg);
+
+/**
+ * @brief Default capacity of the task queue of an executor worker.
+ */
+#define SHIPOVNIK_EXECUTOR_QUEUE 256
+
+/**
+ * @brief Configuration of an executor owned by the library.
+ */
+typedef struct shipovnik_executor_config_st {
+  size_t threads;        ///< Number of workers, `0` means one per online CPU.
+  size_t queue_capacity; ///< Capacity of the task queue of every worker,
+                         ///< `0` means `SHIPOVNIK_EXECUTOR_QUEUE`.
+  const int *cpus;  ///< CPUs to pin workers to, worker `i` runs on CPU
+                    ///< `cpus[i % cpu_count]`. May be `NULL`.
+  size_t cpu_count; ///< Number of CPUs in `cpus`.
+  int numa_node;    ///< NUMA node whose CPUs the workers run on, `-1` for
+                    ///< any. Ignored if `cpus` is given.
+} shipovnik_executor_config_t;
+
+/**
+ * @brief Callbacks that run library tasks on a scheduler of the host.
+ */
+typedef struct shipovnik_executor_hooks_st {
+  void *ctx;          ///< Host scheduler, passed to the callbacks.
+  size_t concurrency; ///< Number of tasks the host runs in parallel.
+  /// Schedules `task(arg)`. Returns a handle of the task, or `NULL` if it can
+  /// not be scheduled, then the library does its work on the calling thread.
+  void *(*submit)(void *ctx, shipovnik_task_fn task, void *arg);
+  /// Blocks until the task of `handle` is complete and releases the handle.
+  void (*wait)(void *ctx, void *handle);
+} shipovnik_executor_hooks_t;
+
+/**
+ * @brief Starts an executor with its own workers. Every worker has a bounded
+ * task deque, takes tasks from its own deque first and steals from the other
+ * workers when it is empty.
+ *
+ * @param[in] config Configuration, `NULL` for defaults.
+ * @return The executor, or `NULL` if it can not be started.
+ */
+shipovnik_executor_t *
+shipovnik_executor_new(const shipovnik_executor_config_t *config);
+
+/**
+ * @brief Creates an executor that runs library tasks through callbacks of the
+ * host scheduler.
+ *
+ * @param[in] hooks Callbacks, copied into the executor.
+ * @return The executor, or `NULL` if it can not be allocated.
+ */
+shipovnik_executor_t *
+shipovnik_executor_new_external(const shipovnik_executor_hooks_t *hooks);
+
+/**
+ * @brief Stops the workers and frees the executor. Must not be called while
+ * the executor is in use.
+ *
+ * @param[in] executor Executor, may be `NULL`.
+ */
+void shipovnik_executor_free(shipovnik_executor_t *executor);
+
+/**
+ * @brief Signature to be verified by `shipovnik_verify_batch`.
+ */
+typedef struct shipovnik_verify_item_st {
+  const uint8_t *pk;  ///< Public key of size `SHIPOVNIK_PUBLICKEYBYTES`.
+  const uint8_t *sig; ///< Signature of size `SHIPOVNIK_SIGBYTES`.
+  const uint8_t *msg; ///< Signed message.
+  size_t msg_len;     ///< The length of a message in bytes.
+} shipovnik_verify_item_t;
+
+/**
+ * @brief Verifies many signatures at once.
+ *
+ * Challenges of all the signatures are derived first, then round checks of
+ * all the signatures are grouped by challenge, so that syndromes and hashes of
+ * many rounds are calculated together.
+ *
+ * @param[in] items Signatures to verify, the contiguous array of size `count`.
+ * @param[in] count Number of signatures.
+ * @param[out] results Contiguous array of size `count` to receive the result
+ *   of every signature: `0` if it is valid, otherwise non-zero value.
+ * @param[in] executor Executor to spread the work over, the calling thread
+ *   takes part too. `NULL` means the calling thread only.
+ * @return `0` if all the signatures are valid, otherwise non-zero value.
+ */
+int shipovnik_verify_batch(const shipovnik_verify_item_t *items, size_t count,
+                           int *results, shipovnik_executor_t *executor);
+
+/**
+ * @brief Value returned by `shipovnik_sign_step` and `shipovnik_verify_step`
+ * when there is work left.
+ */
+#define SHIPOVNIK_AGAIN 1
+
+/**
+ * @brief Bytes of a message hashed per unit of a step budget.
+ */
+#define SHIPOVNIK_STEP_MSG_BYTES 16384
+
+/**
+ * @brief State of a resumable signature generation.
+ */
+typedef struct shipovnik_sign_ctx_st shipovnik_sign_ctx_t;
+
+/**
+ * @brief State of a resumable signature verification.
+ */
+typedef struct shipovnik_verify_ctx_st shipovnik_verify_ctx_t;
+
+/**
+ * @brief Starts resumable signature generation, which produces the same
+ * signature as `shipovnik_sign` in slices of bounded work done by
+ * `shipovnik_sign_step`. Nothing is computed by this call.
+ *
+ * @param[in] sk Secret key, the contiguous array of size
+ *   `SHIPOVNIK_SECRETKEYBYTES`.
+ * @param[in] msg Message to generate signature of, the contiguous array.
+ * @param[in] msg_len The length of a message in bytes.
+ * @param[out] sig Contiguous array to receive signature, of size
+ *   `SHIPOVNIK_SIGBYTES`.
+ * @return The state, or `NULL` if it can not be allocated. `sk`, `msg` and
+ *   `sig` must stay valid until `shipovnik_sign_finish` or
+ *   `shipovnik_sign_cancel` is called.
+ */
+shipovnik_sign_ctx_t *shipovnik_sign_begin(const uint8_t *sk,
+                                           const uint8_t *msg, size_t msg_len,
+                                           uint8_t *sig);
+
+/**
+ * @brief Advances signature generation by at most `budget_rounds` units of
+ * work. A unit is one round of commitments, one round of responses or
+ * `SHIPOVNIK_STEP_MSG_BYTES` bytes of the message.
+ *
+ * @param[in,out] ctx State returned by `shipovnik_sign_begin`.
+ * @param[in] budget_rounds Maximal number of work units.
+ * @return `SHIPOVNIK_AGAIN` if there is work left, otherwise `0`.
+ */
+int shipovnik_sign_step(shipovnik_sign_ctx_t *ctx, size_t budget_rounds);
+
+/**
+ * @brief Completes signature generation, doing all the work left, then
+ * erases and frees the state.
+ *
+ * @param[in] ctx State returned by `shipovnik_sign_begin`.
+ * @param[out] sig_len The result signature size.
+ * @return `0` if the signature is generated, otherwise non-zero value.
+ */
+int shipovnik_sign_finish(shipovnik_sign_ctx_t *ctx, size_t *sig_len);
+
+/**
+ * @brief Abandons signature generation, erases and frees the state.
+ *
+ * @param[in] ctx State returned by `shipovnik_sign_begin`, may be `NULL`.
+ */
+void shipovnik_sign_cancel(shipovnik_sign_ctx_t *ctx);
+
+/**
+ * @brief Starts resumable signature verification, which gives the same
+ * result as `shipovnik_verify` in slices of bounded work done by
+ * `shipovnik_verify_step`. Nothing is computed by this call.
+ *
+ * @param[in] pk Public key, the contiguous array of size
+ *   `SHIPOVNIK_PUBLICKEYBYTES`.
+ * @param[in] sig Signature, the contiguous array of size
+ *   `SHIPOVNIK_SIGBYTES'.
+ * @param[in] msg Message to verify signature of, the contiguous array.
+ * @param[in] msg_len The length of a message in bytes.
+ * @return The state, or `NULL` if it can not be allocated. `pk`, `sig` and
+ *   `msg` must stay valid until `shipovnik_verify_finish` or
+ *   `shipovnik_verify_cancel` is called.
+ */
+shipovnik_verify_ctx_t *shipovnik_verify_begin(const uint8_t *pk,
+                                               const uint8_t *sig,
+                                               const uint8_t *msg,
+                                               size_t msg_len);
+
+/**
+ * @brief Advances signature verification by at most `budget_rounds` units of
+ * work. A unit is one round check or `SHIPOVNIK_STEP_MSG_BYTES` bytes of the
+ * message. Verification stops at the first failed round.
+ *
+ * @param[in,out] ctx State returned by `shipovnik_verify_begin`.
+ * @param[in] budget_rounds Maximal number of work units.
+ * @return `SHIPOVNIK_AGAIN` if there is work left, otherwise `0`.
+ */
+int shipovnik_verify_step(shipovnik_verify_ctx_t *ctx, size_t budget_rounds);
+
+/**
+ * @brief Completes signature verification, doing all the work left, then
+ * erases and frees the state.
+ *
+ * @param[in] ctx State returned by `shipovnik_verify_begin`.
+ * @return `0` if given signature is the signature of given message, otherwise
+ *   non-zero value.
+ */
+int shipovnik_verify_finish(shipovnik_verify_ctx_t *ctx);
+
+/**
+ * @brief Abandons signature verification, erases and frees the state.
+ *
+ * @param[in] ctx State returned by `shipovnik_verify_begin`, may be `NULL`.
+ */
+void shipovnik_verify_cancel(shipovnik_verify_ctx_t *ctx);
+
+/**
+ * @brief Bounded thread-safe cache of verification results.
+ */
+typedef struct shipovnik_verify_cache_st shipovnik_verify_cache_t;
+
+/**
+ * @brief Default number of results remembered by a verification cache.
+ */
+#define SHIPOVNIK_VERIFY_CACHE_ENTRIES 4096
+
+/**
+ * @brief Default number of independently locked parts of a verification
+ * cache.
+ */
+#define SHIPOVNIK_VERIFY_CACHE_SHARDS 16
+
+/**
+ * @brief Configuration of a verification cache.
+ */
+typedef struct shipovnik_verify_cache_config_st {
+  size_t entries;     ///< Number of results to remember, `0` means
+                      ///< `SHIPOVNIK_VERIFY_CACHE_ENTRIES`.
+  size_t shards;      ///< Number of independently locked parts, `0` means
+                      ///< `SHIPOVNIK_VERIFY_CACHE_SHARDS`.
+  int store_failures; ///< Non-zero to remember rejected signatures too.
+} shipovnik_verify_cache_config_t;
+
+/**
+ * @brief Counters of a verification cache.
+ */
+typedef struct shipovnik_verify_cache_stats_st {
+  uint64_t hits;          ///< Results taken from the cache.
+  uint64_t misses;        ///< Signatures verified.
+  uint64_t insertions;    ///< Results stored.
+  uint64_t evictions;     ///< Results dropped to make room.
+  uint64_t invalidations; ///< Results dropped by the invalidation calls.
+} shipovnik_verify_cache_stats_t;
+
+/**
+ * @brief Creates a verification cache. Results are kept in shards selected by
+ * the digest of a signature, every shard is locked separately and replaces
+ * results with the CLOCK policy.
+ *
+ * @param[in] config Configuration, `NULL` for defaults.
+ * @return The cache, or `NULL` if it can not be allocated.
+ */
+shipovnik_verify_cache_t *
+shipovnik_verify_cache_new(const shipovnik_verify_cache_config_t *config);
+
+/**
+ * @brief Frees the cache. Must not be called while the cache is in use.
+ *
+ * @param[in] cache Cache, may be `NULL`.
+ */
+void shipovnik_verify_cache_free(shipovnik_verify_cache_t *cache);
+
+/**
+ * @brief Verifies signature like `shipovnik_verify_checked`, returning the
+ * remembered result if the same signature of the same message under the same
+ * key was verified before.
+ *
+ * Results are keyed by Streebog-512 of `pk || sig || Streebog-512(msg)`, so
+ * the signature and the message are still hashed once per call.
+ *
+ * @param[in] cache Cache, `NULL` means no caching.
+ * @param[in] pk Public key, the contiguous array of size
+ *   `SHIPOVNIK_PUBLICKEYBYTES`.
+ * @param[in] sig Signature, the contiguous array.
+ * @param[in] sig_len The length of a signature in bytes.
+ * @param[in] msg Message to verify signature of, the contiguous array.
+ * @param[in] msg_len The length of a message in bytes.
+ * @return `SHIPOVNIK_VERIFY_OK` if given signature is the signature of given
+ *   message, otherwise the reason of rejection.
+ */
+int shipovnik_verify_cached(shipovnik_verify_cache_t *cache, const uint8_t *pk,
+                            const uint8_t *sig, size_t sig_len,
+                            const uint8_t *msg, size_t msg_len);
+
+/**
+ * @brief Drops all the results remembered for a public key, e.g. when the key
+ * is revoked.
+ *
+ * @param[in] cache Cache.
+ * @param[in] pk Public key, the contiguous array of size
+ *   `SHIPOVNIK_PUBLICKEYBYTES`.
+ */
+void shipovnik_verify_cache_invalidate(shipovnik_verify_cache_t *cache,
+                                       const uint8_t *pk);
+
+/**
+ * @brief Drops all the remembered results.
+ *
+ * @param[in] cache Cache.
+ */
+void shipovnik_verify_cache_clear(shipovnik_verify_cache_t *cache);
+
+/**
+ * @brief Reads the counters of the cache.
+ *
+ * @param[in] cache Cache.
+ * @param[out] stats Counters summed over all the shards.
+ */
+void shipovnik_verify_cache_stats(shipovnik_verify_cache_t *cache,
+                                  shipovnik_verify_cache_stats_t *stats);
+
+/**
+ * @brief State of streaming signature verification.
+ */
+typedef struct shipovnik_verify_stream_st shipovnik_verify_stream_t;
+
+/**
+ * @brief Starts signature verification that consumes the message and then
+ * the signature in parts, as they arrive. Only the commitments and one
+ * response are buffered, so the state takes about 50 KB whatever the size of
+ * the signature.
+ *
+ * @param[in] pk Public key, the contiguous array of size
+ *   `SHIPOVNIK_PUBLICKEYBYTES`, copied into the state.
+ * @return The state, or `NULL` if it can not be allocated.
+ */
+shipovnik_verify_stream_t *shipovnik_verify_stream_begin(const uint8_t *pk);
+
+/**
+ * @brief Absorbs the next part of the message. Must not be called after
+ * `shipovnik_verify_stream_signature`.
+ *
+ * @param[in] ctx State returned by `shipovnik_verify_stream_begin`.
+ * @param[in] part Message part.
+ * @param[in] len The length of a message part in bytes.
+ */
+void shipovnik_verify_stream_message(shipovnik_verify_stream_t *ctx,
+                                     const uint8_t *part, size_t len);
+
+/**
+ * @brief Consumes the next part of the signature. Every round is checked as
+ * soon as its response is complete.
+ *
+ * @param[in] ctx State returned by `shipovnik_verify_stream_begin`.
+ * @param[in] part Signature part.
+ * @param[in] len The length of a signature part in bytes.
+ * @return `0` if the signature may still be valid, otherwise non-zero value,
+ *   then the rest of the signature is not needed.
+ */
+int shipovnik_verify_stream_signature(shipovnik_verify_stream_t *ctx,
+                                      const uint8_t *part, size_t len);
+
+/**
+ * @brief Completes streaming signature verification and frees the state.
+ *
+ * @param[in] ctx State returned by `shipovnik_verify_stream_begin`.
+ * @return `0` if the consumed signature is the signature of the consumed
+ *   message, otherwise non-zero value.
+ */
+int shipovnik_verify_stream_finish(shipovnik_verify_stream_t *ctx);
+
+/**
+ * @brief Abandons streaming signature verification and frees the state.
+ *
+ * @param[in] ctx State returned by `shipovnik_verify_stream_begin`, may be
+ *   `NULL`.
+ */
+void shipovnik_verify_stream_cancel(shipovnik_verify_stream_t *ctx);
+
+/**
+ * @brief Maximal depth of a Merkle tree of documents signed together.
+ */
+#define SHIPOVNIK_MERKLE_DEPTH 32
+
+/**
+ * @brief Maximal size of an inclusion proof: the index and the number of
+ * documents, 4 bytes each, and a hash per tree level.
+ */
+#define SHIPOVNIK_MERKLE_PROOFBYTES                                            \
+  (8 + SHIPOVNIK_MERKLE_DEPTH * GOST512_OUTPUT_BYTES)
+
+/**
+ * @brief Merkle tree of documents signed by a single signature of its root.
+ */
+typedef struct shipovnik_merkle_st shipovnik_merkle_t;
+
+/**
+ * @brief Document added to a Merkle tree by `shipovnik_merkle_add_batch`.
+ */
+typedef struct shipovnik_document_st {
+  const uint8_t *data; ///< Document.
+  size_t len;          ///< The length of a document in bytes.
+} shipovnik_document_t;
+
+/**
+ * @brief Creates an empty Merkle tree.
+ *
+ * Leaves are Streebog-512 hashes of `0x00 || document`, inner nodes are
+ * hashes of `0x01 || left || right`. The last node of a level with odd number
+ * of nodes is moved to the next level as is.
+ *
+ * @return The tree, or `NULL` if it can not be allocated.
+ */
+shipovnik_merkle_t *shipovnik_merkle_new(void);
+
+/**
+ * @brief Frees the tree.
+ *
+ * @param[in] tree Tree, may be `NULL`.
+ */
+void shipovnik_merkle_free(shipovnik_merkle_t *tree);
+
+/**
+ * @brief Hashes the next document into a leaf of the tree, so documents may
+ * be added as they arrive and need not be kept.
+ *
+ * @param[in] tree Tree.
+ * @param[in] doc Document, the contiguous array.
+ * @param[in] doc_len The length of a document in bytes.
+ * @return `0` on success, otherwise non-zero value.
+ */
+int shipovnik_merkle_add(shipovnik_merkle_t *tree, const uint8_t *doc,
+                         size_t doc_len);
+
+/**
+ * @brief Hashes several documents into leaves of the tree in parallel. Leaves
+ * follow in the order of `docs`.
+ *
+ * @param[in] tree Tree.
+ * @param[in] docs Documents, the contiguous array of size `count`.
+ * @param[in] count Number of documents.
+ * @param[in] executor Executor to spread the work over, `NULL` means the
+ *   calling thread only.
+ * @return `0` on success, otherwise non-zero value.
+ */
+int shipovnik_merkle_add_batch(shipovnik_merkle_t *tree,
+                               const shipovnik_document_t *docs, size_t count,
+                               shipovnik_executor_t *executor);
+
+/**
+ * @brief Builds inner levels of the tree over the documents added so far.
+ *
+ * @param[in] tree Tree with at least one document.
+ * @param[in] executor Executor to spread the work over, `NULL` means the
+ *   calling thread only.
+ * @param[out] root Contiguous array to receive the root, of size
+ *   `GOST512_OUTPUT_BYTES`.
+ * @return `0` on success, otherwise non-zero value.
+ */
+int shipovnik_merkle_root(shipovnik_merkle_t *tree,
+                          shipovnik_executor_t *executor, uint8_t *root);
+
+/**
+ * @brief Builds the tree and signs its root with `shipovnik_sign`.
+ *
+ * @param[in] tree Tree with at least one document.
+ * @param[in] sk Secret key, the contiguous array of size
+ *   `SHIPOVNIK_SECRETKEYBYTES`.
+ * @param[in] executor Executor to spread the tree construction over, `NULL`
+ *   means the calling thread only.
+ * @param[out] sig Contiguous array to receive signature, of size
+ *   `SHIPOVNIK_SIGBYTES`.
+ * @param[out] sig_len The result signature size.
+ * @return `0` on success, otherwise non-zero value.
+ */
+int shipovnik_merkle_sign(shipovnik_merkle_t *tree, const uint8_t *sk,
+                          shipovnik_executor_t *executor, uint8_t *sig,
+                          size_t *sig_len);
+
+/**
+ * @brief Produces the inclusion proof of a document in the built tree.
+ *
+ * @param[in] tree Tree built by `shipovnik_merkle_root` or
+ *   `shipovnik_merkle_sign`.
+ * @param[in] index Index of the document in order of addition.
+ * @param[out] proof Contiguous array to receive the proof, of size
+ *   `SHIPOVNIK_MERKLE_PROOFBYTES`.
+ * @param[out] proof_len The result proof size.
+ * @return `0` on success, otherwise non-zero value.
+ */
+int shipovnik_merkle_proof(const shipovnik_merkle_t *tree, size_t index,
+                           uint8_t *proof, size_t *proof_len);
+
+/**
+ * @brief Verifies a document signed as a part of a Merkle tree: recomputes
+ * the root from the document and its inclusion proof, then verifies the
+ * signature of the root through the cache, so the signature shared by the
+ * documents of a tree is verified once.
+ *
+ * @param[in] cache Cache, `NULL` means no caching.
+ * @param[in] pk Public key, the contiguous array of size
+ *   `SHIPOVNIK_PUBLICKEYBYTES`.
+ * @param[in] sig Signature of the root, the contiguous array.
+ * @param[in] sig_len The length of a signature in bytes.
+ * @param[in] doc Document, the contiguous array.
+ * @param[in] doc_len The length of a document in bytes.
+ * @param[in] proof Inclusion proof produced by `shipovnik_merkle_proof`.
+ * @param[in] proof_len The length of a proof in bytes.
+ * @return `SHIPOVNIK_VERIFY_OK` if the document is signed, otherwise the
+ *   reason of rejection.
+ */
+int shipovnik_verify_with_proof(shipovnik_verify_cache_t *cache,
+                                const uint8_t *pk, const uint8_t *sig,
+                                size_t sig_len, const uint8_t *doc,
+                                size_t doc_len, const uint8_t *proof,
+                                size_t proof_len);
+
+/**
+ * @brief Message absorbed once and then signed or verified under many keys.
+ */
+typedef struct shipovnik_message_st shipovnik_message_t;
+
+/**
+ * @brief Creates an empty absorbed message.
+ *
+ * @return The message, or `NULL` if it can not be allocated.
+ */
+shipovnik_message_t *shipovnik_message_new(void);
+
+/**
+ * @brief Absorbs the next part of the message. Must not be called while the
+ * message is signed or verified.
+ *
+ * @param[in] msg Absorbed message.
+ * @param[in] part Message part.
+ * @param[in] len The length of a message part in bytes.
+ */
+void shipovnik_message_update(shipovnik_message_t *msg, const uint8_t *part,
+                              size_t len);
+
+/**
+ * @brief Frees the absorbed message.
+ *
+ * @param[in] msg Absorbed message, may be `NULL`.
+ */
+void shipovnik_message_free(shipovnik_message_t *msg);
+
+/**
+ * @brief Generates signature of the absorbed message, same as
+ * `shipovnik_sign` of the whole message. The hash state of the message is
+ * copied, so the message is not hashed again. May be called from several
+ * threads for the same message.
+ *
+ * @param[in] sk Secret key, the contiguous array of size
+ *   `SHIPOVNIK_SECRETKEYBYTES`.
+ * @param[in] msg Absorbed message.
+ * @param[out] sig Contiguous array to receive signature, of size
+ *   `SHIPOVNIK_SIGBYTES`.
+ * @param[out] sig_len The result signature size.
+ */
+void shipovnik_sign_absorbed(const uint8_t *sk, const shipovnik_message_t *msg,
+                             uint8_t *sig, size_t *sig_len);
+
+/**
+ * @brief Verifies signature of the absorbed message, same as
+ * `shipovnik_verify` of the whole message. May be called from several
+ * threads for the same message.
+ *
+ * @param[in] pk Public key, the contiguous array of size
+ *   `SHIPOVNIK_PUBLICKEYBYTES`.
+ * @param[in] sig Signature, the contiguous array of size
+ *   `SHIPOVNIK_SIGBYTES`.
+ * @param[in] msg Absorbed message.
+ * @return `0` if given signature is the signature of given message, otherwise
+ *   non-zero value.
+ */
+int shipovnik_verify_absorbed(const uint8_t *pk, const uint8_t *sig,
+                              const shipovnik_message_t *msg);
+
+/**
+ * @brief Version of the checkpoint format written by
+ * `shipovnik_message_checkpoint`.
+ */
+#define SHIPOVNIK_CHECKPOINT_VERSION 1
+
+/**
+ * @brief Size of a checkpoint: the header of 16 bytes (magic `SHCP`, version,
+ * number of buffered bytes, 2 zero bytes, big-endian 64-bit message length)
+ * followed by Streebog `h`, `N`, `Sigma` and the buffer of 64 bytes each.
+ */
+#define SHIPOVNIK_CHECKPOINTBYTES 272
+
+/**
+ * @brief Returns the number of bytes absorbed into the message.
+ *
+ * @param[in] msg Absorbed message.
+ */
+uint64_t shipovnik_message_length(const shipovnik_message_t *msg);
+
+/**
+ * @brief Saves the hash state of the absorbed message, so that a message that
+ * grows by appending can later be signed or verified hashing only the tail.
+ * The checkpoint holds no secrets, but must be protected from modification
+ * like the message itself.
+ *
+ * @param[in] msg Absorbed message.
+ * @param[out] checkpoint Contiguous array to receive the checkpoint, of size
+ *   `SHIPOVNIK_CHECKPOINTBYTES`.
+ */
+void shipovnik_message_checkpoint(const shipovnik_message_t *msg,
+                                  uint8_t *checkpoint);
+
+/**
+ * @brief Restores an absorbed message from a checkpoint, the rest of the
+ * message may be absorbed by `shipovnik_message_update`.
+ *
+ * @param[in] checkpoint Checkpoint of size `SHIPOVNIK_CHECKPOINTBYTES`.
+ * @return The message, or `NULL` if the checkpoint is malformed, of another
+ *   version or memory can not be allocated.
+ */
+shipovnik_message_t *shipovnik_message_resume(const uint8_t *checkpoint);
+
+/**
+ * @brief Generates signature of the message saved in a checkpoint extended by
+ * a tail, same as `shipovnik_sign` of the whole message.
+ *
+ * @param[in] sk Secret key, the contiguous array of size
+ *   `SHIPOVNIK_SECRETKEYBYTES`.
+ * @param[in] checkpoint Checkpoint of size `SHIPOVNIK_CHECKPOINTBYTES`.
+ * @param[in] tail The part of a message after the checkpoint.
+ * @param[in] tail_len The length of the tail in bytes.
+ * @param[out] sig Contiguous array to receive signature, of size
+ *   `SHIPOVNIK_SIGBYTES`.
+ * @param[out] sig_len The result signature size.
+ * @return `0` on success, non-zero value if the checkpoint is malformed.
+ */
+int shipovnik_sign_resume(const uint8_t *sk, const uint8_t *checkpoint,
+                          const uint8_t *tail, size_t tail_len, uint8_t *sig,
+                          size_t *sig_len);
+
+/**
+ * @brief Verifies signature of the message saved in a checkpoint extended by
+ * a tail, same as `shipovnik_verify` of the whole message.
+ *
+ * @param[in] pk Public key, the contiguous array of size
+ *   `SHIPOVNIK_PUBLICKEYBYTES`.
+ * @param[in] sig Signature, the contiguous array of size
+ *   `SHIPOVNIK_SIGBYTES`.
+ * @param[in] checkpoint Checkpoint of size `SHIPOVNIK_CHECKPOINTBYTES`.
+ * @param[in] tail The part of a message after the checkpoint.
+ * @param[in] tail_len The length of the tail in bytes.
+ * @return `0` if given signature is the signature of the message, otherwise
+ *   non-zero value, also if the checkpoint is malformed.
+ */
+int shipovnik_verify_resume(const uint8_t *pk, const uint8_t *sig,
+                            const uint8_t *checkpoint, const uint8_t *tail,
+                            size_t tail_len);
+
+/**
+ * @brief Version of the keystore file format.
+ */
+#define SHIPOVNIK_KEYSTORE_VERSION 1
+
+/**
+ * @brief Size of the keystore file header: magic `SHKS`, big-endian 32-bit
+ * version, big-endian 32-bit record size, 4 zero bytes, big-endian 64-bit
+ * number of records, zero padding.
+ */
+#define SHIPOVNIK_KEYSTORE_HEADER_BYTES 64
+
+/**
+ * @brief Size of a keystore record: flags byte (bit 0 is set for a stored
+ * key), 15 zero bytes, the seed of `SHIPOVNIK_SEEDBYTES`, the public key of
+ * `SHIPOVNIK_PUBLICKEYBYTES`, zero padding. Record `i` holds the key with ID
+ * `i`.
+ */
+#define SHIPOVNIK_KEYSTORE_RECORD_BYTES 256
+
+/**
+ * @brief Default number of expanded keys a keystore keeps.
+ */
+#define SHIPOVNIK_KEYSTORE_CACHE 1024
+
+/**
+ * @brief Keystore: a memory-mapped file of key records indexed by key ID and
+ * a bounded cache of expanded keys.
+ */
+typedef struct shipovnik_keystore_st shipovnik_keystore_t;
+
+/**
+ * @brief Expanded key pair held by a caller of `shipovnik_keystore_get`.
+ */
+typedef struct shipovnik_key_st shipovnik_key_t;
+
+/**
+ * @brief Creates a keystore file with empty records.
+ *
+ * @param[in] path Path of the file, it must not exist.
+ * @param[in] capacity Number of records.
+ * @return `0` on success, otherwise non-zero value.
+ */
+int shipovnik_keystore_create(const char *path, uint64_t capacity);
+
+/**
+ * @brief Opens a keystore file. The file is mapped into memory, so records
+ * are read only when their keys are first used.
+ *
+ * @param[in] path Path of the file.
+ * @param[in] cache_entries Number of expanded keys to keep, `0` means
+ *   `SHIPOVNIK_KEYSTORE_CACHE`. Expanded keys are locked in memory if the
+ *   limit of locked memory allows.
+ * @param[in] writable Non-zero to allow `shipovnik_keystore_put`.
+ * @return The keystore, or `NULL` if the file can not be opened or is
+ *   malformed.
+ */
+shipovnik_keystore_t *shipovnik_keystore_open(const char *path,
+                                              size_t cache_entries,
+                                              int writable);
+
+/**
+ * @brief Closes the keystore. Must not be called while keys are held.
+ *
+ * @param[in] ks Keystore, may be `NULL`.
+ */
+void shipovnik_keystore_close(shipovnik_keystore_t *ks);
+
+/**
+ * @brief Returns the number of records of the keystore.
+ *
+ * @param[in] ks Keystore.
+ */
+uint64_t shipovnik_keystore_capacity(const shipovnik_keystore_t *ks);
+
+/**
+ * @brief Stores the key expanded from a seed under an ID, replacing the
+ * stored one. Holders of the replaced key keep using it until they release
+ * it.
+ *
+ * @param[in] ks Keystore opened as writable.
+ * @param[in] id Key ID, less than the capacity.
+ * @param[in] seed Seed, the contiguous array of size `SHIPOVNIK_SEEDBYTES`.
+ * @return `0` on success, otherwise non-zero value.
+ */
+int shipovnik_keystore_put(shipovnik_keystore_t *ks, uint64_t id,
+                           const uint8_t *seed);
+
+/**
+ * @brief Takes the expanded key of an ID. A key in the cache is found without
+ * locks, otherwise its seed is expanded and the least recently used key that
+ * is not held is replaced.
+ *
+ * @param[in] ks Keystore.
+ * @param[in] id Key ID.
+ * @return The key to be released by `shipovnik_keystore_release`, or `NULL`
+ *   if there is no key with this ID, its record is corrupted or all the
+ *   cached keys are held.
+ */
+const shipovnik_key_t *shipovnik_keystore_get(shipovnik_keystore_t *ks,
+                                              uint64_t id);
+
+/**
+ * @brief Releases a key taken by `shipovnik_keystore_get`.
+ *
+ * @param[in] ks Keystore.
+ * @param[in] key Key, may be `NULL`.
+ */
+void shipovnik_keystore_release(shipovnik_keystore_t *ks,
+                                const shipovnik_key_t *key);
+
+/**
+ * @brief Returns the secret key of size `SHIPOVNIK_SECRETKEYBYTES`.
+ *
+ * @param[in] key Held key.
+ */
+const uint8_t *shipovnik_key_secret(const shipovnik_key_t *key);
+
+/**
+ * @brief Returns the public key of size `SHIPOVNIK_PUBLICKEYBYTES`.
+ *
+ * @param[in] key Held key.
+ */
+const uint8_t *shipovnik_key_public(const shipovnik_key_t *key);
+
+/**
+ * @brief Number of histogram buckets of a phase, bucket `i` counts calls
+ * lasting from `2^i` to `2^(i+1) - 1` ticks, bucket `0` also counts calls of
+ * `0` ticks.
+ */
+#define SHIPOVNIK_STATS_BUCKETS 64
+
+/**
+ * @brief Counters of a phase.
+ */
+typedef struct shipovnik_phase_stats_st {
+  uint64_t calls; ///< Number of calls.
+  uint64_t ticks; ///< Total duration of the calls.
+  uint64_t buckets[SHIPOVNIK_STATS_BUCKETS]; ///< Histogram of durations.
+} shipovnik_phase_stats_t;
+
+/**
+ * @brief Counters of all the threads since the instrumentation was enabled
+ * first. Counters only grow, rates are differences of snapshots.
+ */
+typedef struct shipovnik_stats_st {
+  int ticks_are_cycles; ///< `1` if ticks are CPU time stamp counter cycles,
+                        ///< `0` if they are nanoseconds.
+  shipovnik_phase_stats_t phases[SHIPOVNIK_PHASES]; ///< Indexed by phase.
+} shipovnik_stats_t;
+
+/**
+ * @brief Turns the instrumentation on or off for all the threads. It is off
+ * by default and costs a branch per phase while off. Available if the
+ * library is built with `SHIPOVNIK_STATS`.
+ *
+ * @param[in] enabled Non-zero to turn it on.
+ * @return `0` on success, non-zero value if the instrumentation is not built.
+ */
+int shipovnik_stats_enable(int enabled);
+
+/**
+ * @brief Sums the counters of all the threads. Does not stop the threads, so
+ * phases running meanwhile may be counted partially.
+ *
+ * @param[out] stats Counters, zeroed if the instrumentation is not built.
+ */
+void shipovnik_stats_snapshot(shipovnik_stats_t *stats);
+
+/**
+ * @brief Returns the name of a phase, e.g. `"syndrome"`.
+ *
+ * @param[in] phase Phase, one of `SHIPOVNIK_PHASE_*`.
+ * @return The name, or `NULL` for an unknown phase.
+ */
+const char *shipovnik_phase_name(int phase);
@@ -0,0 +1,311 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "hash.h"
+#include "parallel.h"
+#include "params.h"
+#include "shipovnik.h"
+#include "sign.h"
+#include "syndrome.h"
+#include "utils.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// number of rounds checked together
+#define VERIFY_LANES (2 * SYNDROME_LANES)
+
+/**
+ * @brief Check of one round of one signature.
+ */
+typedef struct round_task_st {
+  size_t item;       // index of the signature
+  const uint8_t *ci; // ci0 || ci1 || ci2
+  const uint8_t *ri; // response
+  uint8_t b;         // challenge
+} round_task_st;
+
+typedef struct verify_batch_st {
+  const shipovnik_verify_item_t *items;
+  uint8_t *bs;    // challenges, `DELTA` per signature
+  uint8_t *fails; // non-zero if the challenge of a signature is not derived
+
+  round_task_st *tasks; // rounds with b = 0 or b = 1 followed by b = 2
+  uint8_t *task_fails;  // non-zero if the round check has failed
+  size_t count_all;     // number of rounds
+  size_t count_01;      // number of rounds with b = 0 or b = 1
+  size_t chunks_01;     // number of chunks with b = 0 or b = 1
+} verify_batch_st;
+
+static void derive_challenges(void *arg, size_t begin, size_t end) {
+  verify_batch_st *batch = arg;
+  ALLOC_ON_STACK(uint8_t, h, GOST512_OUTPUT_BYTES);
+
+  for (size_t i = begin; i < end; ++i) {
+    const shipovnik_verify_item_t *item = &batch->items[i];
+
+    // h = hash(M || C)
+    streebog_ctx_t ctx;
+    streebog_512_init(&ctx);
+    streebog_512_update(&ctx, item->msg, item->msg_len);
+    streebog_512_update(&ctx, item->sig, CS_BYTES);
+    streebog_512_final(&ctx, h);
+
+    if (derive_challenge(h, batch->bs + i * DELTA)) {
+      batch->fails[i] = 1;
+    }
+  }
+}
+
+// checks rounds with b = 0 (steps 5.1) and b = 1 (step 5.2)
+static void verify_rounds_01(const verify_batch_st *batch,
+                             const round_task_st *tasks, size_t count,
+                             uint8_t *fails) {
+  ALLOC_ON_STACK(uint8_t, sigma_y_, VERIFY_LANES * SIGMA_Y_SIZE);
+  ALLOC_ON_STACK(uint8_t, u_1, VERIFY_LANES * SHIPOVNIK_SECRETKEYBYTES);
+  ALLOC_ON_STACK(uint8_t, cij_, VERIFY_LANES * GOST512_OUTPUT_BYTES);
+  ALLOC_ON_STACK(uint16_t, sigma, N);
+
+  size_t live[VERIFY_LANES] = {0}; // rounds still checked, by lane
+  const uint8_t *ri1[VERIFY_LANES] = {0};
+  const uint8_t *bufs[VERIFY_LANES] = {0};
+  uint8_t *ys[VERIFY_LANES] = {0};
+  uint8_t *us[VERIFY_LANES] = {0};
+  uint8_t *cijs[VERIFY_LANES] = {0};
+
+  // sigma must be a permutation, rounds failing the check are not hashed
+  size_t lanes = 0;
+  for (size_t l = 0; l < count; ++l) {
+    fails[l] = unpack_sigma(tasks[l].ri, SIGMA_PACKED_BYTES, sigma) != 0 ||
+               check_permutation(sigma) != 0;
+    if (!fails[l]) {
+      live[lanes++] = l;
+    }
+  }
+  if (0 == lanes) {
+    return;
+  }
+
+  for (size_t k = 0; k < lanes; ++k) {
+    const round_task_st *task = &tasks[live[k]];
+    uint8_t *sigma_y = sigma_y_ + k * SIGMA_Y_SIZE;
+    memcpy(sigma_y, task->ri, SIGMA_PACKED_BYTES);
+    ri1[k] = task->ri + SIGMA_PACKED_BYTES;
+    ys[k] = sigma_y + SIGMA_PACKED_BYTES;
+    bufs[k] = sigma_y;
+    us[k] = u_1 + k * SHIPOVNIK_SECRETKEYBYTES;
+    cijs[k] = cij_ + k * GOST512_OUTPUT_BYTES;
+  }
+
+  // calculate ci0_
+  syndrome_batch(H_PRIME, ri1, ys, lanes);
+  for (size_t k = 0; k < lanes; ++k) {
+    const round_task_st *task = &tasks[live[k]];
+    if (task->b == 1) {
+      const uint8_t *pk = batch->items[task->item].pk;
+      bitwise_xor(ys[k], pk, SHIPOVNIK_PUBLICKEYBYTES, ys[k]);
+    }
+  }
+  streebog_512_f_multi(bufs, SIGMA_Y_SIZE, cijs, lanes);
+  for (size_t k = 0; k < lanes; ++k) {
+    const round_task_st *task = &tasks[live[k]];
+    fails[live[k]] = memcmp(task->ci, cijs[k], GOST512_OUTPUT_BYTES) != 0;
+  }
+
+  // calculate ci1_ for b = 0 and ci2_ for b = 1, sigma is unpacked again
+  for (size_t k = 0; k < lanes; ++k) {
+    unpack_sigma(tasks[live[k]].ri, SIGMA_PACKED_BYTES, sigma);
+    apply_permutation(sigma, ri1[k], us[k], N);
+  }
+  streebog_512_f_multi((const uint8_t *const *)us, SHIPOVNIK_SECRETKEYBYTES,
+                       cijs, lanes);
+  for (size_t k = 0; k < lanes; ++k) {
+    const round_task_st *task = &tasks[live[k]];
+    const uint8_t *cij_true = task->ci + (task->b + 1) * GOST512_OUTPUT_BYTES;
+    if (memcmp(cij_true, cijs[k], GOST512_OUTPUT_BYTES)) {
+      fails[live[k]] = 1;
+    }
+  }
+}
+
+// checks rounds with b = 2 (step 5.3)
+static void verify_rounds_2(const round_task_st *tasks, size_t count,
+                            uint8_t *fails) {
+  ALLOC_ON_STACK(uint8_t, u_1, VERIFY_LANES * SHIPOVNIK_SECRETKEYBYTES);
+  ALLOC_ON_STACK(uint8_t, cij_, VERIFY_LANES * GOST512_OUTPUT_BYTES);
+
+  size_t live[VERIFY_LANES] = {0}; // rounds still checked, by lane
+  const uint8_t *ri0[VERIFY_LANES] = {0};
+  const uint8_t *us[VERIFY_LANES] = {0};
+  uint8_t *cijs[VERIFY_LANES] = {0};
+
+  // the vector must be of weight W, rounds failing the check are not hashed
+  size_t lanes = 0;
+  for (size_t l = 0; l < count; ++l) {
+    size_t weight = 0;
+    count_bits(tasks[l].ri + SHIPOVNIK_SECRETKEYBYTES,
+               SHIPOVNIK_SECRETKEYBYTES, &weight);
+    fails[l] = W != weight;
+    if (!fails[l]) {
+      live[lanes++] = l;
+    }
+  }
+  if (0 == lanes) {
+    return;
+  }
+
+  for (size_t k = 0; k < lanes; ++k) {
+    ri0[k] = tasks[live[k]].ri;
+    us[k] = u_1 + k * SHIPOVNIK_SECRETKEYBYTES;
+    cijs[k] = cij_ + k * GOST512_OUTPUT_BYTES;
+  }
+
+  // calculate ci1_, responses are hashed right in the signature
+  streebog_512_f_multi(ri0, SHIPOVNIK_SECRETKEYBYTES, cijs, lanes);
+  for (size_t k = 0; k < lanes; ++k) {
+    const uint8_t *ci1_true = tasks[live[k]].ci + GOST512_OUTPUT_BYTES;
+    fails[live[k]] = memcmp(ci1_true, cijs[k], GOST512_OUTPUT_BYTES) != 0;
+  }
+
+  // calculate ci2_
+  for (size_t k = 0; k < lanes; ++k) {
+    const uint8_t *ri1 = ri0[k] + SHIPOVNIK_SECRETKEYBYTES;
+    bitwise_xor(ri0[k], ri1, SHIPOVNIK_SECRETKEYBYTES,
+                u_1 + k * SHIPOVNIK_SECRETKEYBYTES);
+  }
+  streebog_512_f_multi(us, SHIPOVNIK_SECRETKEYBYTES, cijs, lanes);
+  for (size_t k = 0; k < lanes; ++k) {
+    const uint8_t *ci2_true = tasks[live[k]].ci + 2 * GOST512_OUTPUT_BYTES;
+    if (memcmp(ci2_true, cijs[k], GOST512_OUTPUT_BYTES)) {
+      fails[live[k]] = 1;
+    }
+  }
+}
+
+static void verify_chunks(void *arg, size_t begin, size_t end) {
+  verify_batch_st *batch = arg;
+
+  for (size_t c = begin; c < end; ++c) {
+    // chunks never mix rounds with b = 2 and the others
+    size_t first, last;
+    if (c < batch->chunks_01) {
+      first = c * VERIFY_LANES;
+      last = batch->count_01;
+    } else {
+      first = batch->count_01 + (c - batch->chunks_01) * VERIFY_LANES;
+      last = batch->count_all;
+    }
+    const size_t count =
+        last - first < VERIFY_LANES ? last - first : VERIFY_LANES;
+
+    const round_task_st *tasks = batch->tasks + first;
+    uint8_t *fails = batch->task_fails + first;
+    if (c < batch->chunks_01) {
+      verify_rounds_01(batch, tasks, count, fails);
+    } else {
+      verify_rounds_2(tasks, count, fails);
+    }
+  }
+}
+
+int shipovnik_verify_batch(const shipovnik_verify_item_t *items, size_t count,
+                           int *results, shipovnik_executor_t *executor) {
+  if (count == 0) {
+    return 0;
+  }
+
+  verify_batch_st batch = {.items = items};
+  int ret = 1;
+
+  batch.bs = malloc(count * DELTA);
+  batch.fails = calloc(count, 1);
+  batch.tasks = malloc(count * DELTA * sizeof(round_task_st));
+  batch.task_fails = malloc(count * DELTA);
+  if (NULL == batch.bs || NULL == batch.fails || NULL == batch.tasks ||
+      NULL == batch.task_fails) {
+    for (size_t i = 0; i < count; ++i) {
+      results[i] = 1;
+    }
+    goto cleanup;
+  }
+
+  // steps 1-3 for every signature
+  parallel_for(executor, count, 1, derive_challenges, &batch);
+
+  // group rounds by challenge
+  for (size_t pass = 0; pass < 2; ++pass) {
+    for (size_t i = 0; i < count; ++i) {
+      if (batch.fails[i]) {
+        continue;
+      }
+      const uint8_t *b = batch.bs + i * DELTA;
+      const uint8_t *ci = items[i].sig;
+      const uint8_t *ri = items[i].sig + CS_BYTES;
+      for (size_t j = 0; j < DELTA; ++j) {
+        if ((b[j] == 2) == pass) {
+          round_task_st *task = &batch.tasks[batch.count_all++];
+          task->item = i;
+          task->ci = ci;
+          task->ri = ri;
+          task->b = b[j];
+        }
+        ci += 3 * GOST512_OUTPUT_BYTES;
+        ri += RESPONSE_BYTES(b[j]);
+      }
+    }
+    if (pass == 0) {
+      batch.count_01 = batch.count_all;
+    }
+  }
+  batch.chunks_01 = (batch.count_01 + VERIFY_LANES - 1) / VERIFY_LANES;
+  const size_t chunks =
+      batch.chunks_01 +
+      (batch.count_all - batch.count_01 + VERIFY_LANES - 1) / VERIFY_LANES;
+
+  // step 5 for all the rounds
+  parallel_for(executor, chunks, 1, verify_chunks, &batch);
+
+  ret = 0;
+  for (size_t i = 0; i < count; ++i) {
+    results[i] = batch.fails[i];
+  }
+  for (size_t t = 0; t < batch.count_all; ++t) {
+    if (batch.task_fails[t]) {
+      results[batch.tasks[t].item] = 1;
+    }
+  }
+  for (size_t i = 0; i < count; ++i) {
+    ret |= results[i];
+  }
+
+cleanup:
+  free(batch.bs);
+  free(batch.fails);
+  free(batch.tasks);
+  free(batch.task_fails);
+  return ret;
+}
@@ -0,0 +1,144 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "hash.h"
+#include "params.h"
+#include "probes.h"
+#include "shipovnik.h"
+#include "sign.h"
+#include "utils.h"
+
+#include <stdint.h>
+
+// cost of the check of a round with challenge 0 or 1, the syndrome reads H'
+#define ROUND_01_COST                                                          \
+  (H_PRIME_SIZE + SIGMA_Y_SIZE + SHIPOVNIK_SECRETKEYBYTES)
+// cost of the check of a round with challenge 2
+#define ROUND_2_COST (2 * SHIPOVNIK_SECRETKEYBYTES)
+
+// gets the number of rounds with challenge 0 or 1 from the signature length
+static int rounds_01(size_t sig_len, size_t *count) {
+  const size_t min_len = CS_BYTES + DELTA * RESPONSE_BYTES(2);
+  const size_t step = RESPONSE_BYTES(0) - RESPONSE_BYTES(2);
+
+  if (sig_len < min_len || (sig_len - min_len) % step) {
+    return 1;
+  }
+  *count = (sig_len - min_len) / step;
+  return *count > DELTA;
+}
+
+size_t shipovnik_verify_cost(size_t sig_len, size_t msg_len) {
+  size_t count_01;
+  if (rounds_01(sig_len, &count_01)) {
+    return SIZE_MAX;
+  }
+
+  const size_t rounds_cost = CS_BYTES + count_01 * ROUND_01_COST +
+                             (DELTA - count_01) * ROUND_2_COST;
+  if (msg_len > SIZE_MAX - rounds_cost) {
+    return SIZE_MAX;
+  }
+  return msg_len + rounds_cost;
+}
+
+int shipovnik_verify_checked(const uint8_t *pk, const uint8_t *sig,
+                             size_t sig_len, const uint8_t *msg,
+                             size_t msg_len, size_t budget) {
+  ALLOC_ON_STACK(uint8_t, h, GOST512_OUTPUT_BYTES);
+  ALLOC_ON_STACK(uint8_t, b, DELTA);
+  ALLOC_ON_STACK(uint16_t, sigma, N);
+
+  // free checks
+  size_t count_01;
+  if (rounds_01(sig_len, &count_01)) {
+    return SHIPOVNIK_VERIFY_BAD_LENGTH;
+  }
+  if (shipovnik_verify_cost(sig_len, msg_len) > budget) {
+    return SHIPOVNIK_VERIFY_OVER_BUDGET;
+  }
+
+  // step 1
+  streebog_ctx_t ctx;
+  streebog_512_init(&ctx);
+  streebog_512_update(&ctx, msg, msg_len);
+  streebog_512_update(&ctx, sig, CS_BYTES);
+  streebog_512_final(&ctx, h);
+
+  // steps 2-3
+  if (derive_challenge(h, b)) {
+    return SHIPOVNIK_VERIFY_ERROR;
+  }
+
+  // the length is valid but does not match the challenge of this message
+  size_t count_2 = 0;
+  for (size_t i = 0; i < DELTA; i++) {
+    count_2 += b[i] == 2;
+  }
+  if (count_01 + count_2 != DELTA) {
+    return SHIPOVNIK_VERIFY_MISMATCH;
+  }
+
+  // cheap checks of all the responses
+  const uint8_t *ri = sig + CS_BYTES;
+  for (size_t i = 0; i < DELTA; i++) {
+    if (b[i] == 2) {
+      size_t weight = 0;
+      count_bits(ri + SHIPOVNIK_SECRETKEYBYTES, SHIPOVNIK_SECRETKEYBYTES,
+                 &weight);
+      if (W != weight) {
+        PROBE3(verify__fail, i, b[i], ROUND_BAD_WEIGHT);
+        return SHIPOVNIK_VERIFY_BAD_WEIGHT;
+      }
+    } else {
+      if (unpack_sigma(ri, SIGMA_PACKED_BYTES, sigma) ||
+          check_permutation(sigma)) {
+        PROBE3(verify__fail, i, b[i], ROUND_BAD_PERMUTATION);
+        return SHIPOVNIK_VERIFY_BAD_PERMUTATION;
+      }
+    }
+    ri += RESPONSE_BYTES(b[i]);
+  }
+
+  // steps 4-5, the cheapest rounds first
+  for (int pass = 2; pass >= 0; pass -= 2) {
+    const uint8_t *ci = sig;
+    ri = sig + CS_BYTES;
+    for (size_t i = 0; i < DELTA; i++) {
+      if ((b[i] == 2) == (pass == 2)) {
+        const int reason = verify_round(pk, b[i], ci, ri);
+        if (reason) {
+          PROBE3(verify__fail, i, b[i], reason);
+          return SHIPOVNIK_VERIFY_MISMATCH;
+        }
+      }
+      ci += 3 * GOST512_OUTPUT_BYTES;
+      ri += RESPONSE_BYTES(b[i]);
+    }
+  }
+
+  return SHIPOVNIK_VERIFY_OK;
+}
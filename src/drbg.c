@@ -0,0 +1,81 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "drbg.h"
+#include "hash.h"
+#include "params.h"
+#include "utils.h"
+
+#include <string.h>
+
+// size of the input of a block: the seed and the counter
+#define DRBG_INPUT_BYTES (DRBG_SEED_BYTES + 8)
+
+void drbg_init(drbg_t *drbg, const uint8_t *seed) {
+  memcpy(drbg->seed, seed, DRBG_SEED_BYTES);
+  drbg->counter = 0;
+}
+
+void drbg_generate(drbg_t *drbg, uint8_t *out, size_t len) {
+  ALLOC_ON_STACK(uint8_t, inputs, STREEBOG_LANES * DRBG_INPUT_BYTES);
+  ALLOC_ON_STACK(uint8_t, tail, GOST512_OUTPUT_BYTES);
+  const uint8_t *bufs[STREEBOG_LANES];
+  uint8_t *results[STREEBOG_LANES];
+  // bytes taken from the last, partial block
+  size_t tail_len = 0;
+
+  while (len > 0) {
+    // hash up to `STREEBOG_LANES` blocks in lockstep
+    size_t lanes = 0;
+    for (; lanes < STREEBOG_LANES && len > 0; ++lanes) {
+      uint8_t *input = inputs + lanes * DRBG_INPUT_BYTES;
+      memcpy(input, drbg->seed, DRBG_SEED_BYTES);
+      for (size_t i = 0; i < 8; ++i) {
+        input[DRBG_SEED_BYTES + i] = (uint8_t)(drbg->counter >> (56 - 8 * i));
+      }
+      drbg->counter++;
+
+      bufs[lanes] = input;
+      if (len >= GOST512_OUTPUT_BYTES) {
+        results[lanes] = out;
+        out += GOST512_OUTPUT_BYTES;
+        len -= GOST512_OUTPUT_BYTES;
+      } else {
+        // the partial block is the last one
+        results[lanes] = tail;
+        tail_len = len;
+        len = 0;
+      }
+    }
+    streebog_512_f_multi(bufs, DRBG_INPUT_BYTES, results, lanes);
+  }
+  memcpy(out, tail, tail_len);
+
+  SECURE_ERASE(uint8_t, inputs, STREEBOG_LANES * DRBG_INPUT_BYTES);
+  SECURE_ERASE(uint8_t, tail, GOST512_OUTPUT_BYTES);
+}
+
+void drbg_erase(drbg_t *drbg) { secure_erase(drbg, sizeof(drbg_t)); }
@@ -0,0 +1,65 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// size of the seed of `drbg_init`
+#define DRBG_SEED_BYTES 32
+
+/**
+ * @brief Deterministic random bit generator: Streebog-512 of the seed and a
+ * big endian block counter, in counter mode. The input of a block fits in one
+ * Streebog block, so a block of output costs three compressions.
+ */
+typedef struct drbg_st {
+  uint8_t seed[DRBG_SEED_BYTES];
+  uint64_t counter;
+} drbg_t;
+
+/**
+ * @brief Seeds the generator.
+ * @param[out] drbg Generator to be initialized.
+ * @param[in] seed Seed of size `DRBG_SEED_BYTES`.
+ */
+void drbg_init(drbg_t *drbg, const uint8_t *seed);
+
+/**
+ * @brief Generates the next bytes. Output is taken in whole blocks, so a
+ * request of `len` bytes consumes `ceil(len / 64)` blocks.
+ * @param[in,out] drbg Seeded generator.
+ * @param[out] out Output buffer.
+ * @param[in] len Output length.
+ */
+void drbg_generate(drbg_t *drbg, uint8_t *out, size_t len);
+
+/**
+ * @brief Erases the state of the generator.
+ * @param[in,out] drbg Generator.
+ */
+void drbg_erase(drbg_t *drbg);
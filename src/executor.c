@@ -0,0 +1,442 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifdef __linux__
+#define _GNU_SOURCE // pthread_setaffinity_np
+#include <sched.h>
+#endif // __linux__
+
+#include "parallel.h"
+#include "shipovnik.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @brief Task scheduled on an executor owned by the library.
+ */
+typedef struct task_st {
+  shipovnik_task_fn fn;
+  void *arg;
+  atomic_int done;
+} task_st;
+
+/**
+ * @brief Bounded task deque of a worker. The owner pushes and pops tasks at
+ * the tail, thieves steal the oldest tasks from the head.
+ */
+typedef struct deque_st {
+  pthread_mutex_t lock;
+  task_st **tasks; // ring buffer of `capacity` tasks
+  size_t head;
+  size_t tail;
+} deque_st;
+
+typedef struct worker_st {
+  shipovnik_executor_t *executor;
+  size_t index;
+  pthread_t thread;
+} worker_st;
+
+struct shipovnik_executor_st {
+  // set for an executor of the host
+  int external;
+  shipovnik_executor_hooks_t hooks;
+
+  size_t threads;
+  size_t capacity;
+  worker_st *workers;
+  deque_st *deques;
+  int *cpus; // CPU set of every worker, `threads` x `cpu_count`, or NULL
+  size_t cpu_count;
+
+  atomic_size_t queued; // number of tasks in all the deques
+  atomic_size_t next;   // deque to push the next external task to
+  int stop;
+  pthread_mutex_t lock;
+  pthread_cond_t wake; // signalled when a task is queued or on stop
+  pthread_cond_t done; // broadcast when a task is complete
+};
+
+// worker the current thread is, if any
+static _Thread_local worker_st *current_worker = NULL;
+
+static int deque_push(shipovnik_executor_t *ex, deque_st *d, task_st *task) {
+  pthread_mutex_lock(&d->lock);
+  const int full = d->tail - d->head == ex->capacity;
+  if (!full) {
+    d->tasks[d->tail++ % ex->capacity] = task;
+  }
+  pthread_mutex_unlock(&d->lock);
+  return full;
+}
+
+static task_st *deque_pop(shipovnik_executor_t *ex, deque_st *d) {
+  task_st *task = NULL;
+  pthread_mutex_lock(&d->lock);
+  if (d->tail != d->head) {
+    task = d->tasks[--d->tail % ex->capacity];
+  }
+  pthread_mutex_unlock(&d->lock);
+  return task;
+}
+
+static task_st *deque_steal(shipovnik_executor_t *ex, deque_st *d) {
+  task_st *task = NULL;
+  pthread_mutex_lock(&d->lock);
+  if (d->tail != d->head) {
+    task = d->tasks[d->head++ % ex->capacity];
+  }
+  pthread_mutex_unlock(&d->lock);
+  return task;
+}
+
+// takes a task from the own deque of worker `self`, then from the others
+static task_st *find_task(shipovnik_executor_t *ex, size_t self) {
+  if (atomic_load(&ex->queued) == 0) {
+    return NULL;
+  }
+  task_st *task = deque_pop(ex, &ex->deques[self]);
+  for (size_t i = 1; NULL == task && i < ex->threads; ++i) {
+    task = deque_steal(ex, &ex->deques[(self + i) % ex->threads]);
+  }
+  if (NULL != task) {
+    atomic_fetch_sub(&ex->queued, 1);
+  }
+  return task;
+}
+
+static void run_task(shipovnik_executor_t *ex, task_st *task) {
+  task->fn(task->arg);
+
+  pthread_mutex_lock(&ex->lock);
+  atomic_store(&task->done, 1);
+  pthread_cond_broadcast(&ex->done);
+  pthread_mutex_unlock(&ex->lock);
+}
+
+static void pin_worker(const worker_st *w) {
+#ifdef __linux__
+  const shipovnik_executor_t *ex = w->executor;
+  if (NULL == ex->cpus) {
+    return;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  const int *cpus = ex->cpus + w->index * ex->cpu_count;
+  for (size_t i = 0; i < ex->cpu_count; ++i) {
+    if (cpus[i] >= 0 && cpus[i] < CPU_SETSIZE) {
+      CPU_SET(cpus[i], &set);
+    }
+  }
+  // pinning is best effort, e.g. CPUs may be taken away by a cgroup
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else  // __linux__
+  (void)w;
+#endif // __linux__
+}
+
+static void *worker_main(void *p) {
+  worker_st *w = p;
+  shipovnik_executor_t *ex = w->executor;
+  current_worker = w;
+  pin_worker(w);
+
+  for (;;) {
+    task_st *task = find_task(ex, w->index);
+    if (NULL != task) {
+      run_task(ex, task);
+      continue;
+    }
+
+    pthread_mutex_lock(&ex->lock);
+    while (!ex->stop && atomic_load(&ex->queued) == 0) {
+      pthread_cond_wait(&ex->wake, &ex->lock);
+    }
+    const int stop = ex->stop;
+    pthread_mutex_unlock(&ex->lock);
+    if (stop) {
+      break;
+    }
+  }
+  return NULL;
+}
+
+// parses a Linux CPU list, e.g. "0-3,8,10-11", returns the number of CPUs
+static size_t parse_cpu_list(const char *list, int *cpus, size_t max) {
+  size_t count = 0;
+  const char *p = list;
+  while (*p) {
+    char *end;
+    const long first = strtol(p, &end, 10);
+    if (end == p) {
+      break;
+    }
+    long last = first;
+    p = end;
+    if (*p == '-') {
+      last = strtol(p + 1, &end, 10);
+      p = end;
+    }
+    for (long cpu = first; cpu <= last && count < max; ++cpu) {
+      cpus[count++] = (int)cpu;
+    }
+    if (*p != ',') {
+      break;
+    }
+    ++p;
+  }
+  return count;
+}
+
+// reads the CPUs of a NUMA node, returns the number of CPUs
+static size_t numa_node_cpus(int node, int *cpus, size_t max) {
+  char path[64];
+  char list[1024];
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+           node);
+  FILE *f = fopen(path, "r");
+  if (NULL == f) {
+    return 0;
+  }
+  const int ok = NULL != fgets(list, sizeof(list), f);
+  fclose(f);
+  return ok ? parse_cpu_list(list, cpus, max) : 0;
+}
+
+// CPU sets of the workers according to the configuration
+static int assign_cpus(shipovnik_executor_t *ex,
+                       const shipovnik_executor_config_t *config) {
+  if (NULL != config->cpus && config->cpu_count > 0) {
+    // one CPU per worker
+    ex->cpu_count = 1;
+    ex->cpus = malloc(ex->threads * sizeof(int));
+    if (NULL == ex->cpus) {
+      return 1;
+    }
+    for (size_t i = 0; i < ex->threads; ++i) {
+      ex->cpus[i] = config->cpus[i % config->cpu_count];
+    }
+    return 0;
+  }
+
+  if (config->numa_node < 0) {
+    return 0;
+  }
+
+  // every worker may run on any CPU of the node
+  int node_cpus[1024];
+  const size_t count = numa_node_cpus(config->numa_node, node_cpus, 1024);
+  if (0 == count) {
+    return 0;
+  }
+  ex->cpu_count = count;
+  ex->cpus = malloc(ex->threads * count * sizeof(int));
+  if (NULL == ex->cpus) {
+    return 1;
+  }
+  for (size_t i = 0; i < ex->threads; ++i) {
+    memcpy(ex->cpus + i * count, node_cpus, count * sizeof(int));
+  }
+  return 0;
+}
+
+shipovnik_executor_t *
+shipovnik_executor_new(const shipovnik_executor_config_t *config) {
+  const shipovnik_executor_config_t defaults = {0, 0, NULL, 0, -1};
+  if (NULL == config) {
+    config = &defaults;
+  }
+
+  shipovnik_executor_t *ex = calloc(1, sizeof(shipovnik_executor_t));
+  if (NULL == ex) {
+    return NULL;
+  }
+
+  ex->threads = config->threads;
+  if (0 == ex->threads) {
+    const long online = sysconf(_SC_NPROCESSORS_ONLN);
+    ex->threads = online > 0 ? (size_t)online : 1;
+  }
+  ex->capacity = config->queue_capacity ? config->queue_capacity
+                                        : SHIPOVNIK_EXECUTOR_QUEUE;
+  pthread_mutex_init(&ex->lock, NULL);
+  pthread_cond_init(&ex->wake, NULL);
+  pthread_cond_init(&ex->done, NULL);
+
+  ex->workers = calloc(ex->threads, sizeof(worker_st));
+  ex->deques = calloc(ex->threads, sizeof(deque_st));
+  if (NULL == ex->workers || NULL == ex->deques || assign_cpus(ex, config)) {
+    ex->threads = 0;
+    shipovnik_executor_free(ex);
+    return NULL;
+  }
+
+  size_t started = 0;
+  for (; started < ex->threads; ++started) {
+    deque_st *d = &ex->deques[started];
+    d->tasks = malloc(ex->capacity * sizeof(task_st *));
+    if (NULL == d->tasks) {
+      break;
+    }
+    pthread_mutex_init(&d->lock, NULL);
+
+    worker_st *w = &ex->workers[started];
+    w->executor = ex;
+    w->index = started;
+    if (pthread_create(&w->thread, NULL, worker_main, w)) {
+      pthread_mutex_destroy(&d->lock);
+      free(d->tasks);
+      break;
+    }
+  }
+  if (started < ex->threads) {
+    ex->threads = started;
+    shipovnik_executor_free(ex);
+    return NULL;
+  }
+
+  return ex;
+}
+
+shipovnik_executor_t *
+shipovnik_executor_new_external(const shipovnik_executor_hooks_t *hooks) {
+  shipovnik_executor_t *ex = calloc(1, sizeof(shipovnik_executor_t));
+  if (NULL == ex) {
+    return NULL;
+  }
+  ex->external = 1;
+  ex->hooks = *hooks;
+  return ex;
+}
+
+void shipovnik_executor_free(shipovnik_executor_t *ex) {
+  if (NULL == ex) {
+    return;
+  }
+
+  if (!ex->external) {
+    pthread_mutex_lock(&ex->lock);
+    ex->stop = 1;
+    pthread_cond_broadcast(&ex->wake);
+    pthread_mutex_unlock(&ex->lock);
+
+    for (size_t i = 0; i < ex->threads; ++i) {
+      pthread_join(ex->workers[i].thread, NULL);
+      pthread_mutex_destroy(&ex->deques[i].lock);
+      free(ex->deques[i].tasks);
+    }
+    pthread_cond_destroy(&ex->done);
+    pthread_cond_destroy(&ex->wake);
+    pthread_mutex_destroy(&ex->lock);
+  }
+
+  free(ex->workers);
+  free(ex->deques);
+  free(ex->cpus);
+  free(ex);
+}
+
+size_t executor_concurrency(const shipovnik_executor_t *ex) {
+  if (NULL == ex) {
+    return 1;
+  }
+  if (ex->external) {
+    return ex->hooks.concurrency ? ex->hooks.concurrency : 1;
+  }
+  // the calling thread takes part in the work too
+  return current_worker != NULL && current_worker->executor == ex
+             ? ex->threads
+             : ex->threads + 1;
+}
+
+void *executor_submit(shipovnik_executor_t *ex, shipovnik_task_fn fn,
+                      void *arg) {
+  if (NULL == ex) {
+    return NULL;
+  }
+  if (ex->external) {
+    return ex->hooks.submit(ex->hooks.ctx, fn, arg);
+  }
+
+  task_st *task = malloc(sizeof(task_st));
+  if (NULL == task) {
+    return NULL;
+  }
+  task->fn = fn;
+  task->arg = arg;
+  atomic_init(&task->done, 0);
+
+  // a worker keeps its subtasks, other threads spread tasks round robin
+  size_t index;
+  if (current_worker != NULL && current_worker->executor == ex) {
+    index = current_worker->index;
+  } else {
+    index = atomic_fetch_add(&ex->next, 1) % ex->threads;
+  }
+  // counted before it can be taken, so that the count never wraps below 0
+  atomic_fetch_add(&ex->queued, 1);
+  if (deque_push(ex, &ex->deques[index], task)) {
+    atomic_fetch_sub(&ex->queued, 1);
+    free(task);
+    return NULL;
+  }
+
+  pthread_mutex_lock(&ex->lock);
+  pthread_cond_signal(&ex->wake);
+  pthread_mutex_unlock(&ex->lock);
+  return task;
+}
+
+void executor_wait(shipovnik_executor_t *ex, void *handle) {
+  if (ex->external) {
+    ex->hooks.wait(ex->hooks.ctx, handle);
+    return;
+  }
+
+  task_st *task = handle;
+  const int is_worker = current_worker != NULL && current_worker->executor == ex;
+  while (!atomic_load(&task->done)) {
+    // a worker helps instead of blocking, the task may be in its own deque
+    task_st *other = is_worker ? find_task(ex, current_worker->index) : NULL;
+    if (NULL != other) {
+      run_task(ex, other);
+      continue;
+    }
+
+    pthread_mutex_lock(&ex->lock);
+    while (!atomic_load(&task->done) &&
+           !(is_worker && atomic_load(&ex->queued) > 0)) {
+      pthread_cond_wait(&ex->done, &ex->lock);
+    }
+    pthread_mutex_unlock(&ex->lock);
+  }
+  free(task);
+}
@@ -27,6 +27,7 @@
 #include "genvector.h"
 #include "params.h"
 #include "randombytes.h"
+#include "stats.h"
 
 #include <stddef.h>
 #include <string.h>
@@ -72,6 +73,7 @@ static void uint64_sort(uint64_t *arr, uint16_t arr_size) {
 }
 
 void shuffle(const uint32_t *p, uint16_t *pi, uint64_t *buf, size_t len) {
+  STATS_BEGIN(start);
   const uint64_t mask = 0xFFFF;
   for (size_t i = 0; i < len; ++i) {
     buf[i] = p[i];
@@ -84,18 +86,22 @@ void shuffle(const uint32_t *p, uint16_t *pi, uint64_t *buf, size_t len) {
   for (size_t i = 0; i < len; i++) {
     pi[i] = buf[i] & mask;
   }
+  STATS_END(SHIPOVNIK_PHASE_SHUFFLE, start);
 }
 
-void gen_vector(uint16_t *s) {
+void gen_vector_from(const uint32_t *entropy, uint16_t *s) {
 
   memset(s + W, 0, sizeof(uint16_t) * (N - W));
   for (size_t i = 0; i < W; ++i) {
     s[i] = 1;
   }
 
-  uint32_t entropy[N];
-  randombytes((uint8_t *)entropy, N * 4);
-
   uint64_t buf[N];
   shuffle(entropy, s, buf, N);
 }
+
+void gen_vector(uint16_t *s) {
+  uint32_t entropy[N];
+  randombytes((uint8_t *)entropy, N * 4);
+  gen_vector_from(entropy, s);
+}
@@ -42,3 +42,11 @@ void shuffle(const uint32_t *p, uint16_t *pi, uint64_t *buf, size_t len);
  * @param[out] s buffer to be filled. Should have size at least 'N'.
  */
 void gen_vector(uint16_t *s);
+
+/**
+ * @brief Generate binary vector of weight `W` from given entropy, same as
+ * `gen_vector` drawing the entropy from `randombytes`.
+ * @param[in] entropy random array of size `N`
+ * @param[out] s buffer to be filled. Should have size at least 'N'.
+ */
+void gen_vector_from(const uint32_t *entropy, uint16_t *s);
@@ -0,0 +1,80 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "hash.h"
+#include "utils.h"
+
+#include "gost3411-2012-core.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Update function of a streebog core.
+ */
+typedef void (*gost_update_fn)(GOST34112012Context *, const unsigned char *,
+                               size_t);
+
+/**
+ * @brief Feeds a message part of any alignment to a streebog core. The SSE
+ * cores load whole input blocks with aligned loads, so the blocks that are
+ * not 16 bytes aligned are compressed from an aligned copy.
+ * @param[in] ctx Context, 16 bytes aligned.
+ * @param[in] buf Message part.
+ * @param[in] len Message part length.
+ * @param[in] update Update function of the core.
+ */
+static inline void gost_update_aligned(GOST34112012Context *ctx,
+                                       const uint8_t *buf, size_t len,
+                                       gost_update_fn update) {
+  if (ctx->bufsize) {
+    // tops up the buffer of the context, which is aligned
+    const size_t chunk = len < GOST_BLOCK_BYTES - ctx->bufsize
+                             ? len
+                             : GOST_BLOCK_BYTES - ctx->bufsize;
+    update(ctx, buf, chunk);
+    buf += chunk;
+    len -= chunk;
+  }
+  if ((uintptr_t)buf % 0x10 == 0x00) {
+    update(ctx, buf, len);
+    return;
+  }
+  if (len >= GOST_BLOCK_BYTES) {
+    ALIGN(16) uint8_t block[GOST_BLOCK_BYTES];
+    for (; len >= GOST_BLOCK_BYTES;
+         buf += GOST_BLOCK_BYTES, len -= GOST_BLOCK_BYTES) {
+      memcpy(block, buf, GOST_BLOCK_BYTES);
+      update(ctx, block, GOST_BLOCK_BYTES);
+    }
+    // secure sensitive data
+    SECURE_ERASE(uint8_t, block, GOST_BLOCK_BYTES);
+  }
+  // the rest is buffered by the context
+  update(ctx, buf, len);
+}
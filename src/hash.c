@@ -25,11 +25,17 @@
 */
 
 #include "hash.h"
+#include "gost_update.h"
+#include "stats.h"
 #include "utils.h"
 
 #include "gost3411-2012-core.h"
 
-#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(sizeof(GOST34112012Context) <= STREEBOG_CTX_BYTES,
+               "STREEBOG_CTX_BYTES is too small");
+
 
 static GOST34112012Context *
 CTX(unsigned char data[sizeof(GOST34112012Context) + 16]) {
@@ -43,7 +49,7 @@ CTX(unsigned char data[sizeof(GOST34112012Context) + 16]) {
 
 static void streebog_digest_f(const uint8_t *buf, size_t len, uint8_t *result,
                               unsigned int digest_size) {
-  unsigned char *data = malloc(sizeof(GOST34112012Context) + 16);
+  unsigned char data[sizeof(GOST34112012Context) + 16];
   GOST34112012Context *ctx = CTX(data);
 
   GOST34112012Init(ctx, digest_size);
@@ -52,7 +58,7 @@ static void streebog_digest_f(const uint8_t *buf, size_t len, uint8_t *result,
     ALLOC_ON_STACK(uint8_t, reversed_buf, len);
 
     reverse(buf, len, reversed_buf);
-    GOST34112012Update(ctx, reversed_buf, len);
+    gost_update_aligned(ctx, reversed_buf, len, GOST34112012Update);
 
     // secure sensitive data
     SECURE_ERASE(uint8_t, reversed_buf, len);
@@ -61,15 +67,89 @@ static void streebog_digest_f(const uint8_t *buf, size_t len, uint8_t *result,
     GOST34112012Cleanup(ctx);
     reverse_inplace(result, digest_size / 8);
   } else { // 512
-    GOST34112012Update(ctx, buf, len);
+    gost_update_aligned(ctx, buf, len, GOST34112012Update);
 
     GOST34112012Final(ctx, result);
     GOST34112012Cleanup(ctx);
   }
-
-  free(data);
 }
 
 void streebog_512_f(const uint8_t *buf, size_t len, uint8_t *result) {
+  STATS_BEGIN(start);
   streebog_digest_f(buf, len, result, 512);
+  STATS_END(SHIPOVNIK_PHASE_HASH, start);
+}
+
+void streebog_512_init(streebog_ctx_t *ctx) {
+  GOST34112012Init(CTX(ctx->data), 512);
+}
+
+void streebog_512_update(streebog_ctx_t *ctx, const uint8_t *buf, size_t len) {
+  STATS_BEGIN(start);
+  gost_update_aligned(CTX(ctx->data), buf, len, GOST34112012Update);
+  STATS_END(SHIPOVNIK_PHASE_HASH, start);
+}
+
+void streebog_512_copy(streebog_ctx_t *dst, const streebog_ctx_t *src) {
+  // contexts may be aligned differently inside the storage
+  memcpy(CTX(dst->data), CTX((unsigned char *)src->data),
+         sizeof(GOST34112012Context));
+}
+
+void streebog_512_get_state(const streebog_ctx_t *ctx,
+                            streebog_state_t *state) {
+  const GOST34112012Context *gctx = CTX((unsigned char *)ctx->data);
+  memcpy(state->h, &gctx->h, GOST_BLOCK_BYTES);
+  memcpy(state->n, &gctx->N, GOST_BLOCK_BYTES);
+  memcpy(state->sigma, &gctx->Sigma, GOST_BLOCK_BYTES);
+  memset(state->buffer, 0, GOST_BLOCK_BYTES);
+  memcpy(state->buffer, gctx->buffer, gctx->bufsize);
+  state->buffered = gctx->bufsize;
+}
+
+int streebog_512_set_state(streebog_ctx_t *ctx, const streebog_state_t *state) {
+  if (state->buffered >= GOST_BLOCK_BYTES) {
+    return 1;
+  }
+  GOST34112012Context *gctx = CTX(ctx->data);
+  GOST34112012Init(gctx, 512);
+  memcpy(&gctx->h, state->h, GOST_BLOCK_BYTES);
+  memcpy(&gctx->N, state->n, GOST_BLOCK_BYTES);
+  memcpy(&gctx->Sigma, state->sigma, GOST_BLOCK_BYTES);
+  memcpy(gctx->buffer, state->buffer, state->buffered);
+  gctx->bufsize = state->buffered;
+  return 0;
+}
+
+void streebog_512_final(streebog_ctx_t *ctx, uint8_t *result) {
+  STATS_BEGIN(start);
+  GOST34112012Context *gctx = CTX(ctx->data);
+  GOST34112012Final(gctx, result);
+  GOST34112012Cleanup(gctx);
+  STATS_END(SHIPOVNIK_PHASE_HASH, start);
+}
+
+void streebog_512_f_multi(const uint8_t *const *bufs, size_t len,
+                          uint8_t *const *results, size_t count) {
+  streebog_ctx_t ctx[STREEBOG_LANES];
+
+  for (size_t i = 0; i < count; i += STREEBOG_LANES) {
+    const size_t lanes =
+        count - i < STREEBOG_LANES ? count - i : STREEBOG_LANES;
+
+    for (size_t l = 0; l < lanes; ++l) {
+      streebog_512_init(&ctx[l]);
+    }
+    // feed whole blocks, so that every update is compressed in place
+    for (size_t off = 0; off < len; off += GOST_BLOCK_BYTES) {
+      const size_t chunk =
+          len - off < GOST_BLOCK_BYTES ? len - off : GOST_BLOCK_BYTES;
+      for (size_t l = 0; l < lanes; ++l) {
+        streebog_512_update(&ctx[l], bufs[i + l] + off, chunk);
+      }
+    }
+    for (size_t l = 0; l < lanes; ++l) {
+      streebog_512_final(&ctx[l], results[i + l]);
+    }
+  }
 }
@@ -29,6 +29,24 @@
 #include <stddef.h>
 #include <stdint.h>
 
+// size of a block compressed by Streebog
+#define GOST_BLOCK_BYTES 64
+
+// upper bound of `sizeof(GOST34112012Context)`
+#define STREEBOG_CTX_BYTES 336
+
+// number of messages hashed in lockstep by `streebog_512_f_multi`
+#define STREEBOG_LANES 4
+
+/**
+ * @brief Incremental Streebog-512 hashing context. Holds the streebog library
+ * context, which requires 16 bytes alignment, so the storage has extra room
+ * to align it. Must not be copied by assignment.
+ */
+typedef struct streebog_ctx_st {
+  unsigned char data[STREEBOG_CTX_BYTES + 16];
+} streebog_ctx_t;
+
 /**
  * @brief Calculates the Streebog-512F has of given message
  * @param[in] buf Message whose hash is to be calculated.
@@ -37,3 +55,76 @@
  * `GOST512_OUTPUT_BYTES`.
  */
 void streebog_512_f(const uint8_t *buf, size_t len, uint8_t *result);
+
+/**
+ * @brief Starts the incremental calculation of a Streebog-512 hash.
+ * @param[out] ctx Context to be initialized.
+ */
+void streebog_512_init(streebog_ctx_t *ctx);
+
+/**
+ * @brief Absorbs the next part of a message.
+ * @param[in,out] ctx Initialized context.
+ * @param[in] buf Message part.
+ * @param[in] len Message part length.
+ */
+void streebog_512_update(streebog_ctx_t *ctx, const uint8_t *buf, size_t len);
+
+/**
+ * @brief Copies the state of a context, so that the same message prefix can
+ * be completed in several ways.
+ * @param[out] dst Context to receive the state.
+ * @param[in] src Initialized context.
+ */
+void streebog_512_copy(streebog_ctx_t *dst, const streebog_ctx_t *src);
+
+/**
+ * @brief Midstate of a Streebog-512 context: chaining value `h`, processed
+ * length `N` and checksum `Sigma` in their in-memory byte order, which is the
+ * same for both byte orders supported by the streebog library, and the bytes
+ * not yet compressed.
+ */
+typedef struct streebog_state_st {
+  uint8_t h[GOST_BLOCK_BYTES];
+  uint8_t n[GOST_BLOCK_BYTES];
+  uint8_t sigma[GOST_BLOCK_BYTES];
+  uint8_t buffer[GOST_BLOCK_BYTES];
+  size_t buffered; // number of bytes in `buffer`, less than a block
+} streebog_state_t;
+
+/**
+ * @brief Reads the midstate of a context.
+ * @param[in] ctx Initialized context.
+ * @param[out] state Midstate.
+ */
+void streebog_512_get_state(const streebog_ctx_t *ctx,
+                            streebog_state_t *state);
+
+/**
+ * @brief Initializes a context with a midstate.
+ * @param[out] ctx Context to be initialized.
+ * @param[in] state Midstate read by `streebog_512_get_state`.
+ * @return 0 on success, 1 if `state` is malformed.
+ */
+int streebog_512_set_state(streebog_ctx_t *ctx, const streebog_state_t *state);
+
+/**
+ * @brief Completes the hash calculation and erases the context.
+ * @param[in,out] ctx Initialized context.
+ * @param[out] result Output buffer. Should have size at least
+ * `GOST512_OUTPUT_BYTES`.
+ */
+void streebog_512_final(streebog_ctx_t *ctx, uint8_t *result);
+
+/**
+ * @brief Calculates the Streebog-512F hashes of several messages of the same
+ * length. Messages are processed in groups of `STREEBOG_LANES` block by block,
+ * so that all contexts of a group stay on the stack next to each other.
+ * @param[in] bufs Messages whose hashes are to be calculated.
+ * @param[in] len Length of every message.
+ * @param[out] results Output buffers, each of size at least
+ * `GOST512_OUTPUT_BYTES`.
+ * @param[in] count Number of messages.
+ */
+void streebog_512_f_multi(const uint8_t *const *bufs, size_t len,
+                          uint8_t *const *results, size_t count);
@@ -0,0 +1,129 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "drbg.h"
+#include "genvector.h"
+#include "parallel.h"
+#include "params.h"
+#include "randombytes.h"
+#include "shipovnik.h"
+#include "syndrome.h"
+#include "utils.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+_Static_assert(DRBG_SEED_BYTES == SHIPOVNIK_SEEDBYTES,
+               "a seed must seed the generator");
+
+typedef struct keygen_job_st {
+  uint8_t *sks;
+  uint8_t *pks;
+  atomic_int failed;
+} keygen_job_st;
+
+// packs a binary vector into bytes, most significant bit first
+static void pack_secret_key(const uint16_t *s, uint8_t *sk) {
+  for (size_t j = 0; j < SHIPOVNIK_SECRETKEYBYTES; ++j) {
+    uint8_t byte = 0;
+    for (size_t k = 0; k < 8; ++k) {
+      byte = (uint8_t)(byte << 1) | (s[8 * j + k] & 1);
+    }
+    sk[j] = byte;
+  }
+}
+
+// generates keys `[begin, end)`, at most `SYNDROME_LANES` of them
+static void generate_keys_group(void *arg, size_t begin, size_t end) {
+  keygen_job_st *job = arg;
+  const size_t count = end - begin;
+  ALLOC_ON_STACK(uint16_t, s, N);
+  const uint8_t *vs[SYNDROME_LANES];
+  uint8_t *ss[SYNDROME_LANES];
+
+  uint32_t *entropy = malloc(SYNDROME_LANES * N * sizeof(uint32_t));
+  if (NULL == entropy) {
+    atomic_store(&job->failed, 1);
+    return;
+  }
+  randombytes((uint8_t *)entropy, count * N * sizeof(uint32_t));
+
+  for (size_t k = 0; k < count; ++k) {
+    uint8_t *sk = job->sks + (begin + k) * SHIPOVNIK_SECRETKEYBYTES;
+    gen_vector_from(entropy + k * N, s);
+    pack_secret_key(s, sk);
+    vs[k] = sk;
+    ss[k] = job->pks + (begin + k) * SHIPOVNIK_PUBLICKEYBYTES;
+  }
+  syndrome_batch(H_PRIME, vs, ss, count);
+
+  SECURE_ERASE(uint16_t, s, N);
+  secure_erase(entropy, SYNDROME_LANES * N * sizeof(uint32_t));
+  free(entropy);
+}
+
+int shipovnik_generate_keys_batch(size_t count, uint8_t *sks, uint8_t *pks,
+                                  shipovnik_executor_t *executor) {
+  keygen_job_st job = {.sks = sks, .pks = pks};
+  atomic_init(&job.failed, 0);
+  parallel_for(executor, count, SYNDROME_LANES, generate_keys_group, &job);
+  return atomic_load(&job.failed);
+}
+
+void shipovnik_expand_seed(const uint8_t *seed, uint8_t *sk, uint8_t *pk) {
+  ALLOC_ON_STACK(uint8_t, bytes, N * sizeof(uint32_t));
+  ALLOC_ON_STACK(uint32_t, entropy, N);
+  ALLOC_ON_STACK(uint16_t, s, N);
+
+  drbg_t drbg;
+  drbg_init(&drbg, seed);
+  drbg_generate(&drbg, bytes, N * sizeof(uint32_t));
+  drbg_erase(&drbg);
+
+  // little endian, so that a seed expands the same on any platform
+  for (size_t i = 0; i < N; ++i) {
+    const uint8_t *b = bytes + i * sizeof(uint32_t);
+    entropy[i] = (uint32_t)b[0] | ((uint32_t)b[1] << 8) |
+                 ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+  }
+  gen_vector_from(entropy, s);
+  pack_secret_key(s, sk);
+  if (NULL != pk) {
+    syndrome(H_PRIME, sk, pk);
+  }
+
+  SECURE_ERASE(uint8_t, bytes, N * sizeof(uint32_t));
+  SECURE_ERASE(uint32_t, entropy, N);
+  SECURE_ERASE(uint16_t, s, N);
+}
+
+void shipovnik_generate_seed(uint8_t *seed, uint8_t *pk) {
+  ALLOC_ON_STACK(uint8_t, sk, SHIPOVNIK_SECRETKEYBYTES);
+  randombytes(seed, SHIPOVNIK_SEEDBYTES);
+  shipovnik_expand_seed(seed, sk, pk);
+  SECURE_ERASE(uint8_t, sk, SHIPOVNIK_SECRETKEYBYTES);
+}
@@ -0,0 +1,393 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifdef __linux__
+#define _GNU_SOURCE // MADV_DONTDUMP
+#endif // __linux__
+
+#include "params.h"
+#include "shipovnik.h"
+#include "utils.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define KEYSTORE_MAGIC "SHKS"
+
+// layout of a record
+#define RECORD_PRESENT 0x01
+#define RECORD_SEED_OFFSET 16
+#define RECORD_PK_OFFSET (RECORD_SEED_OFFSET + SHIPOVNIK_SEEDBYTES)
+
+_Static_assert(RECORD_PK_OFFSET + SHIPOVNIK_PUBLICKEYBYTES <=
+                   SHIPOVNIK_KEYSTORE_RECORD_BYTES,
+               "a key does not fit into a record");
+
+// set in `refs` while a key is being replaced
+#define KEY_EVICTING (1u << 31)
+// ID of a key that holds nothing
+#define NO_KEY UINT64_MAX
+// slot of a key that is not in the table
+#define NO_SLOT SIZE_MAX
+
+struct shipovnik_key_st {
+  uint8_t sk[SHIPOVNIK_SECRETKEYBYTES];
+  uint8_t pk[SHIPOVNIK_PUBLICKEYBYTES];
+  _Atomic uint64_t id;
+  atomic_uint refs;
+  atomic_uchar referenced; // CLOCK mark
+  size_t slot;             // slot of the table the key is published in
+};
+
+struct shipovnik_keystore_st {
+  int fd;
+  int writable;
+  uint8_t *map;
+  size_t map_len;
+  uint64_t capacity;
+
+  // expanded keys, never freed while the keystore is open, so a reader may
+  // touch a key found in the table even if it is being replaced
+  shipovnik_key_t *keys;
+  size_t key_count;
+  size_t keys_len;
+
+  // direct-mapped table from IDs to keys, read without locks
+  _Atomic(shipovnik_key_t *) *table;
+  size_t table_mask;
+
+  pthread_mutex_t lock; // serializes loading, replacing and storing of keys
+  size_t hand;          // CLOCK hand over `keys`
+};
+
+static void store_be(uint8_t *p, uint64_t v, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    p[i] = (uint8_t)(v >> (8 * (len - 1 - i)));
+  }
+}
+
+static uint64_t load_be(const uint8_t *p, size_t len) {
+  uint64_t v = 0;
+  for (size_t i = 0; i < len; ++i) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+
+static size_t slot_of(const shipovnik_keystore_t *ks, uint64_t id) {
+  // splitmix64 finalizer, so that consecutive IDs spread over the table
+  id ^= id >> 30;
+  id *= 0xbf58476d1ce4e5b9ULL;
+  id ^= id >> 27;
+  id *= 0x94d049bb133111ebULL;
+  id ^= id >> 31;
+  return (size_t)id & ks->table_mask;
+}
+
+static uint8_t *record_of(const shipovnik_keystore_t *ks, uint64_t id) {
+  return ks->map + SHIPOVNIK_KEYSTORE_HEADER_BYTES +
+         id * SHIPOVNIK_KEYSTORE_RECORD_BYTES;
+}
+
+int shipovnik_keystore_create(const char *path, uint64_t capacity) {
+  if (capacity > (UINT64_MAX - SHIPOVNIK_KEYSTORE_HEADER_BYTES) /
+                     SHIPOVNIK_KEYSTORE_RECORD_BYTES) {
+    return 1;
+  }
+
+  uint8_t header[SHIPOVNIK_KEYSTORE_HEADER_BYTES] = {0};
+  memcpy(header, KEYSTORE_MAGIC, 4);
+  store_be(header + 4, SHIPOVNIK_KEYSTORE_VERSION, 4);
+  store_be(header + 8, SHIPOVNIK_KEYSTORE_RECORD_BYTES, 4);
+  store_be(header + 16, capacity, 8);
+
+  const int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0600);
+  if (fd == -1) {
+    return 1;
+  }
+  // records past the header are left as holes, which read as empty records
+  const off_t size = (off_t)(SHIPOVNIK_KEYSTORE_HEADER_BYTES +
+                             capacity * SHIPOVNIK_KEYSTORE_RECORD_BYTES);
+  int ret = ftruncate(fd, size) != 0 ||
+            write(fd, header, sizeof(header)) != (ssize_t)sizeof(header);
+  ret |= close(fd) != 0;
+  if (ret) {
+    unlink(path);
+  }
+  return ret;
+}
+
+static int map_file(shipovnik_keystore_t *ks, const char *path) {
+  ks->fd = open(path, ks->writable ? O_RDWR : O_RDONLY);
+  if (ks->fd == -1) {
+    return 1;
+  }
+
+  struct stat st;
+  if (fstat(ks->fd, &st) != 0 ||
+      (uint64_t)st.st_size < SHIPOVNIK_KEYSTORE_HEADER_BYTES ||
+      (uint64_t)st.st_size > SIZE_MAX) {
+    return 1;
+  }
+  ks->map_len = (size_t)st.st_size;
+  const int prot = ks->writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  void *map = mmap(NULL, ks->map_len, prot, MAP_SHARED, ks->fd, 0);
+  if (map == MAP_FAILED) {
+    return 1;
+  }
+  ks->map = map;
+
+  const uint8_t *header = ks->map;
+  ks->capacity = load_be(header + 16, 8);
+  if (memcmp(header, KEYSTORE_MAGIC, 4) ||
+      load_be(header + 4, 4) != SHIPOVNIK_KEYSTORE_VERSION ||
+      load_be(header + 8, 4) != SHIPOVNIK_KEYSTORE_RECORD_BYTES ||
+      ks->capacity > (ks->map_len - SHIPOVNIK_KEYSTORE_HEADER_BYTES) /
+                         SHIPOVNIK_KEYSTORE_RECORD_BYTES) {
+    return 1;
+  }
+  return 0;
+}
+
+static int alloc_keys(shipovnik_keystore_t *ks, size_t count) {
+  ks->key_count = count;
+  ks->keys_len = count * sizeof(shipovnik_key_t);
+  void *keys = mmap(NULL, ks->keys_len, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (keys == MAP_FAILED) {
+    ks->keys_len = 0;
+    return 1;
+  }
+  ks->keys = keys;
+  // best effort, the limit of locked memory may be too low
+  (void)mlock(ks->keys, ks->keys_len);
+#ifdef MADV_DONTDUMP
+  (void)madvise(ks->keys, ks->keys_len, MADV_DONTDUMP);
+#endif
+
+  for (size_t i = 0; i < count; ++i) {
+    atomic_init(&ks->keys[i].id, NO_KEY);
+    atomic_init(&ks->keys[i].refs, 0);
+    atomic_init(&ks->keys[i].referenced, 0);
+    ks->keys[i].slot = NO_SLOT;
+  }
+
+  size_t table_size = 1;
+  while (table_size < 2 * count) {
+    table_size <<= 1;
+  }
+  ks->table_mask = table_size - 1;
+  ks->table = calloc(table_size, sizeof(*ks->table));
+  return NULL == ks->table;
+}
+
+shipovnik_keystore_t *shipovnik_keystore_open(const char *path,
+                                              size_t cache_entries,
+                                              int writable) {
+  shipovnik_keystore_t *ks = calloc(1, sizeof(shipovnik_keystore_t));
+  if (NULL == ks) {
+    return NULL;
+  }
+  ks->fd = -1;
+  ks->writable = writable;
+  pthread_mutex_init(&ks->lock, NULL);
+
+  if (map_file(ks, path) ||
+      alloc_keys(ks, cache_entries ? cache_entries
+                                   : SHIPOVNIK_KEYSTORE_CACHE)) {
+    shipovnik_keystore_close(ks);
+    return NULL;
+  }
+  return ks;
+}
+
+void shipovnik_keystore_close(shipovnik_keystore_t *ks) {
+  if (NULL == ks) {
+    return;
+  }
+
+  if (NULL != ks->keys) {
+    secure_erase(ks->keys, ks->keys_len);
+    munlock(ks->keys, ks->keys_len);
+    munmap(ks->keys, ks->keys_len);
+  }
+  free(ks->table);
+  if (NULL != ks->map) {
+    munmap(ks->map, ks->map_len);
+  }
+  if (ks->fd != -1) {
+    close(ks->fd);
+  }
+  pthread_mutex_destroy(&ks->lock);
+  free(ks);
+}
+
+uint64_t shipovnik_keystore_capacity(const shipovnik_keystore_t *ks) {
+  return ks->capacity;
+}
+
+// takes a reference to a key found in the table if it holds `id`
+static int try_acquire(shipovnik_key_t *key, uint64_t id) {
+  const unsigned refs = atomic_fetch_add(&key->refs, 1);
+  if ((refs & KEY_EVICTING) || atomic_load(&key->id) != id) {
+    atomic_fetch_sub(&key->refs, 1);
+    return 0;
+  }
+  return 1;
+}
+
+// finds a key that is not held with CLOCK and marks it as being replaced
+static shipovnik_key_t *evict(shipovnik_keystore_t *ks) {
+  for (size_t step = 0; step < 2 * ks->key_count; ++step) {
+    shipovnik_key_t *key = &ks->keys[ks->hand];
+    ks->hand = (ks->hand + 1) % ks->key_count;
+
+    if (atomic_exchange(&key->referenced, 0)) {
+      continue;
+    }
+    unsigned expected = 0;
+    if (atomic_compare_exchange_strong(&key->refs, &expected, KEY_EVICTING)) {
+      if (key->slot != NO_SLOT) {
+        shipovnik_key_t *published = key;
+        atomic_compare_exchange_strong(&ks->table[key->slot], &published,
+                                       NULL);
+        key->slot = NO_SLOT;
+      }
+      atomic_store(&key->id, NO_KEY);
+      return key;
+    }
+  }
+  return NULL;
+}
+
+// expands the stored key of `id` into `key`
+static int load(const shipovnik_keystore_t *ks, uint64_t id,
+                shipovnik_key_t *key) {
+  const uint8_t *record = record_of(ks, id);
+  if (!(record[0] & RECORD_PRESENT)) {
+    return 1;
+  }
+  shipovnik_expand_seed(record + RECORD_SEED_OFFSET, key->sk, key->pk);
+  // the public key detects a damaged seed
+  return memcmp(key->pk, record + RECORD_PK_OFFSET, SHIPOVNIK_PUBLICKEYBYTES);
+}
+
+const shipovnik_key_t *shipovnik_keystore_get(shipovnik_keystore_t *ks,
+                                              uint64_t id) {
+  if (id >= ks->capacity) {
+    return NULL;
+  }
+
+  const size_t slot = slot_of(ks, id);
+  shipovnik_key_t *key = atomic_load(&ks->table[slot]);
+  if (NULL != key && try_acquire(key, id)) {
+    atomic_store(&key->referenced, 1);
+    return key;
+  }
+
+  pthread_mutex_lock(&ks->lock);
+  // another thread may have loaded the key meanwhile
+  key = atomic_load(&ks->table[slot]);
+  if (NULL != key && try_acquire(key, id)) {
+    pthread_mutex_unlock(&ks->lock);
+    atomic_store(&key->referenced, 1);
+    return key;
+  }
+
+  key = evict(ks);
+  if (NULL == key) {
+    pthread_mutex_unlock(&ks->lock);
+    return NULL;
+  }
+  if (load(ks, id, key)) {
+    secure_erase(key->sk, SHIPOVNIK_SECRETKEYBYTES);
+    atomic_fetch_and(&key->refs, ~KEY_EVICTING);
+    pthread_mutex_unlock(&ks->lock);
+    return NULL;
+  }
+
+  atomic_store(&key->id, id);
+  atomic_store(&key->referenced, 1);
+  key->slot = slot;
+  // the caller's reference, then let the readers in
+  atomic_fetch_add(&key->refs, 1);
+  atomic_fetch_and(&key->refs, ~KEY_EVICTING);
+  atomic_store(&ks->table[slot], key);
+  pthread_mutex_unlock(&ks->lock);
+  return key;
+}
+
+void shipovnik_keystore_release(shipovnik_keystore_t *ks,
+                                const shipovnik_key_t *key) {
+  (void)ks;
+  if (NULL != key) {
+    atomic_fetch_sub(&((shipovnik_key_t *)key)->refs, 1);
+  }
+}
+
+int shipovnik_keystore_put(shipovnik_keystore_t *ks, uint64_t id,
+                           const uint8_t *seed) {
+  if (!ks->writable || id >= ks->capacity) {
+    return 1;
+  }
+
+  ALLOC_ON_STACK(uint8_t, sk, SHIPOVNIK_SECRETKEYBYTES);
+  ALLOC_ON_STACK(uint8_t, pk, SHIPOVNIK_PUBLICKEYBYTES);
+  shipovnik_expand_seed(seed, sk, pk);
+  SECURE_ERASE(uint8_t, sk, SHIPOVNIK_SECRETKEYBYTES);
+
+  pthread_mutex_lock(&ks->lock);
+  uint8_t *record = record_of(ks, id);
+  memset(record, 0, SHIPOVNIK_KEYSTORE_RECORD_BYTES);
+  memcpy(record + RECORD_SEED_OFFSET, seed, SHIPOVNIK_SEEDBYTES);
+  memcpy(record + RECORD_PK_OFFSET, pk, SHIPOVNIK_PUBLICKEYBYTES);
+  record[0] = RECORD_PRESENT;
+
+  // the replaced key stays with its holders, but is not found any more
+  const size_t slot = slot_of(ks, id);
+  shipovnik_key_t *key = atomic_load(&ks->table[slot]);
+  if (NULL != key && atomic_load(&key->id) == id) {
+    atomic_store(&ks->table[slot], NULL);
+    key->slot = NO_SLOT;
+    atomic_store(&key->id, NO_KEY);
+  }
+  pthread_mutex_unlock(&ks->lock);
+  return 0;
+}
+
+const uint8_t *shipovnik_key_secret(const shipovnik_key_t *key) {
+  return key->sk;
+}
+
+const uint8_t *shipovnik_key_public(const shipovnik_key_t *key) {
+  return key->pk;
+}
@@ -0,0 +1,315 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "hash.h"
+#include "parallel.h"
+#include "params.h"
+#include "shipovnik.h"
+#include "utils.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LEAF_PREFIX 0x00
+#define NODE_PREFIX 0x01
+
+// size of the input of an inner node hash
+#define NODE_INPUT_BYTES (1 + 2 * GOST512_OUTPUT_BYTES)
+
+// number of leaves hashed by a task of `shipovnik_merkle_add_batch`
+#define LEAF_GRAIN 16
+// number of inner nodes hashed by a task of `shipovnik_merkle_root`
+#define NODE_GRAIN 256
+
+struct shipovnik_merkle_st {
+  size_t count; // number of leaves
+  size_t capacity;
+  uint8_t *leaves;
+  // inner levels, valid if `built` is set
+  uint8_t *nodes;
+  int built;
+  size_t depth;
+  uint8_t *levels[SHIPOVNIK_MERKLE_DEPTH + 1];
+  size_t level_counts[SHIPOVNIK_MERKLE_DEPTH + 1];
+};
+
+static void hash_leaf(const uint8_t *doc, size_t doc_len, uint8_t *leaf) {
+  const uint8_t prefix = LEAF_PREFIX;
+  streebog_ctx_t ctx;
+  streebog_512_init(&ctx);
+  streebog_512_update(&ctx, &prefix, 1);
+  streebog_512_update(&ctx, doc, doc_len);
+  streebog_512_final(&ctx, leaf);
+}
+
+static void hash_node(const uint8_t *left, const uint8_t *right,
+                      uint8_t *node) {
+  ALLOC_ON_STACK(uint8_t, input, NODE_INPUT_BYTES);
+  input[0] = NODE_PREFIX;
+  memcpy(input + 1, left, GOST512_OUTPUT_BYTES);
+  memcpy(input + 1 + GOST512_OUTPUT_BYTES, right, GOST512_OUTPUT_BYTES);
+  streebog_512_f(input, NODE_INPUT_BYTES, node);
+}
+
+// makes room for `count` more leaves, drops the inner levels
+static int reserve(shipovnik_merkle_t *tree, size_t count) {
+  tree->built = 0;
+  if (count > UINT32_MAX - tree->count) {
+    return 1;
+  }
+  if (tree->count + count <= tree->capacity) {
+    return 0;
+  }
+
+  size_t capacity = tree->capacity ? tree->capacity : 64;
+  while (capacity < tree->count + count) {
+    capacity *= 2;
+  }
+  uint8_t *leaves = realloc(tree->leaves, capacity * GOST512_OUTPUT_BYTES);
+  if (NULL == leaves) {
+    return 1;
+  }
+  tree->leaves = leaves;
+  tree->capacity = capacity;
+  return 0;
+}
+
+shipovnik_merkle_t *shipovnik_merkle_new(void) {
+  return calloc(1, sizeof(shipovnik_merkle_t));
+}
+
+void shipovnik_merkle_free(shipovnik_merkle_t *tree) {
+  if (NULL == tree) {
+    return;
+  }
+  free(tree->leaves);
+  free(tree->nodes);
+  free(tree);
+}
+
+int shipovnik_merkle_add(shipovnik_merkle_t *tree, const uint8_t *doc,
+                         size_t doc_len) {
+  if (reserve(tree, 1)) {
+    return 1;
+  }
+  hash_leaf(doc, doc_len, tree->leaves + tree->count * GOST512_OUTPUT_BYTES);
+  tree->count++;
+  return 0;
+}
+
+typedef struct leaf_job_st {
+  const shipovnik_document_t *docs;
+  uint8_t *leaves;
+} leaf_job_st;
+
+static void hash_leaves(void *arg, size_t begin, size_t end) {
+  const leaf_job_st *job = arg;
+  for (size_t i = begin; i < end; ++i) {
+    hash_leaf(job->docs[i].data, job->docs[i].len,
+              job->leaves + i * GOST512_OUTPUT_BYTES);
+  }
+}
+
+int shipovnik_merkle_add_batch(shipovnik_merkle_t *tree,
+                               const shipovnik_document_t *docs, size_t count,
+                               shipovnik_executor_t *executor) {
+  if (reserve(tree, count)) {
+    return 1;
+  }
+  leaf_job_st job = {docs, tree->leaves + tree->count * GOST512_OUTPUT_BYTES};
+  parallel_for(executor, count, LEAF_GRAIN, hash_leaves, &job);
+  tree->count += count;
+  return 0;
+}
+
+typedef struct level_job_st {
+  const uint8_t *below;
+  size_t below_count;
+  uint8_t *level;
+} level_job_st;
+
+// hashes nodes `[begin, end)` of a level, `STREEBOG_LANES` at a time
+static void hash_level(void *arg, size_t begin, size_t end) {
+  const level_job_st *job = arg;
+  ALLOC_ON_STACK(uint8_t, inputs, STREEBOG_LANES * NODE_INPUT_BYTES);
+  const uint8_t *bufs[STREEBOG_LANES];
+  uint8_t *results[STREEBOG_LANES];
+  size_t lanes = 0;
+
+  for (size_t i = begin; i < end; ++i) {
+    const uint8_t *left = job->below + 2 * i * GOST512_OUTPUT_BYTES;
+    uint8_t *node = job->level + i * GOST512_OUTPUT_BYTES;
+    if (2 * i + 1 == job->below_count) {
+      // the odd node is moved up
+      memcpy(node, left, GOST512_OUTPUT_BYTES);
+      continue;
+    }
+
+    uint8_t *input = inputs + lanes * NODE_INPUT_BYTES;
+    input[0] = NODE_PREFIX;
+    memcpy(input + 1, left, 2 * GOST512_OUTPUT_BYTES);
+    bufs[lanes] = input;
+    results[lanes] = node;
+    if (++lanes == STREEBOG_LANES) {
+      streebog_512_f_multi(bufs, NODE_INPUT_BYTES, results, lanes);
+      lanes = 0;
+    }
+  }
+  streebog_512_f_multi(bufs, NODE_INPUT_BYTES, results, lanes);
+}
+
+int shipovnik_merkle_root(shipovnik_merkle_t *tree,
+                          shipovnik_executor_t *executor, uint8_t *root) {
+  if (0 == tree->count) {
+    return 1;
+  }
+
+  if (!tree->built) {
+    size_t total = 0;
+    size_t depth = 0;
+    for (size_t n = tree->count; n > 1; n = (n + 1) / 2) {
+      total += (n + 1) / 2;
+      depth++;
+    }
+
+    free(tree->nodes);
+    tree->nodes = NULL;
+    if (total > 0) {
+      tree->nodes = malloc(total * GOST512_OUTPUT_BYTES);
+      if (NULL == tree->nodes) {
+        return 1;
+      }
+    }
+
+    tree->levels[0] = tree->leaves;
+    tree->level_counts[0] = tree->count;
+    uint8_t *level = tree->nodes;
+    for (size_t l = 1; l <= depth; ++l) {
+      const size_t below_count = tree->level_counts[l - 1];
+      tree->levels[l] = level;
+      tree->level_counts[l] = (below_count + 1) / 2;
+
+      level_job_st job = {tree->levels[l - 1], below_count, level};
+      parallel_for(executor, tree->level_counts[l], NODE_GRAIN, hash_level,
+                   &job);
+      level += tree->level_counts[l] * GOST512_OUTPUT_BYTES;
+    }
+    tree->depth = depth;
+    tree->built = 1;
+  }
+
+  memcpy(root, tree->levels[tree->depth], GOST512_OUTPUT_BYTES);
+  return 0;
+}
+
+int shipovnik_merkle_sign(shipovnik_merkle_t *tree, const uint8_t *sk,
+                          shipovnik_executor_t *executor, uint8_t *sig,
+                          size_t *sig_len) {
+  ALLOC_ON_STACK(uint8_t, root, GOST512_OUTPUT_BYTES);
+  if (shipovnik_merkle_root(tree, executor, root)) {
+    return 1;
+  }
+  // the length is not written if signing fails
+  *sig_len = 0;
+  shipovnik_sign(sk, root, GOST512_OUTPUT_BYTES, sig, sig_len);
+  return 0 == *sig_len;
+}
+
+static void store_u32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+static uint32_t load_u32(const uint8_t *p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+         ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+int shipovnik_merkle_proof(const shipovnik_merkle_t *tree, size_t index,
+                           uint8_t *proof, size_t *proof_len) {
+  if (!tree->built || index >= tree->count) {
+    return 1;
+  }
+
+  store_u32(proof, (uint32_t)index);
+  store_u32(proof + 4, (uint32_t)tree->count);
+  *proof_len = 8;
+  for (size_t l = 0; l < tree->depth; ++l) {
+    const size_t sibling = index ^ 1;
+    if (sibling < tree->level_counts[l]) {
+      memcpy(proof + *proof_len,
+             tree->levels[l] + sibling * GOST512_OUTPUT_BYTES,
+             GOST512_OUTPUT_BYTES);
+      *proof_len += GOST512_OUTPUT_BYTES;
+    }
+    index >>= 1;
+  }
+  return 0;
+}
+
+int shipovnik_verify_with_proof(shipovnik_verify_cache_t *cache,
+                                const uint8_t *pk, const uint8_t *sig,
+                                size_t sig_len, const uint8_t *doc,
+                                size_t doc_len, const uint8_t *proof,
+                                size_t proof_len) {
+  ALLOC_ON_STACK(uint8_t, node, GOST512_OUTPUT_BYTES);
+
+  if (proof_len < 8) {
+    return SHIPOVNIK_VERIFY_BAD_PROOF;
+  }
+  size_t index = load_u32(proof);
+  size_t count = load_u32(proof + 4);
+  if (index >= count) {
+    return SHIPOVNIK_VERIFY_BAD_PROOF;
+  }
+  const uint8_t *sibling = proof + 8;
+  const uint8_t *const end = proof + proof_len;
+
+  hash_leaf(doc, doc_len, node);
+  for (; count > 1; count = (count + 1) / 2, index >>= 1) {
+    if ((index ^ 1) >= count) {
+      continue; // moved up as is
+    }
+    if (end - sibling < GOST512_OUTPUT_BYTES) {
+      return SHIPOVNIK_VERIFY_BAD_PROOF;
+    }
+    if (index & 1) {
+      hash_node(sibling, node, node);
+    } else {
+      hash_node(node, sibling, node);
+    }
+    sibling += GOST512_OUTPUT_BYTES;
+  }
+  if (sibling != end) {
+    return SHIPOVNIK_VERIFY_BAD_PROOF;
+  }
+
+  return shipovnik_verify_cached(cache, pk, sig, sig_len, node,
+                                 GOST512_OUTPUT_BYTES);
+}
@@ -0,0 +1,184 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "hash.h"
+#include "probes.h"
+#include "shipovnik.h"
+#include "sign.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// layout of a checkpoint
+#define CHECKPOINT_MAGIC "SHCP"
+#define CHECKPOINT_VERSION_OFFSET 4
+#define CHECKPOINT_BUFFERED_OFFSET 5
+#define CHECKPOINT_LENGTH_OFFSET 8
+#define CHECKPOINT_STATE_OFFSET 16
+
+_Static_assert(CHECKPOINT_STATE_OFFSET + 4 * GOST_BLOCK_BYTES ==
+                   SHIPOVNIK_CHECKPOINTBYTES,
+               "SHIPOVNIK_CHECKPOINTBYTES does not match the layout");
+
+struct shipovnik_message_st {
+  streebog_ctx_t hash; // state after absorbing the message, hash(M || ...)
+  uint64_t len;
+};
+
+shipovnik_message_t *shipovnik_message_new(void) {
+  shipovnik_message_t *msg = malloc(sizeof(shipovnik_message_t));
+  if (NULL == msg) {
+    return NULL;
+  }
+  streebog_512_init(&msg->hash);
+  msg->len = 0;
+  return msg;
+}
+
+void shipovnik_message_update(shipovnik_message_t *msg, const uint8_t *part,
+                              size_t len) {
+  PROBE1(message__hash__begin, len);
+  streebog_512_update(&msg->hash, part, len);
+  PROBE1(message__hash__end, len);
+  msg->len += len;
+}
+
+void shipovnik_message_free(shipovnik_message_t *msg) { free(msg); }
+
+void shipovnik_sign_absorbed(const uint8_t *sk, const shipovnik_message_t *msg,
+                             uint8_t *sig, size_t *sig_len) {
+  sign_absorbed(sk, &msg->hash, sig, sig_len);
+}
+
+int shipovnik_verify_absorbed(const uint8_t *pk, const uint8_t *sig,
+                              const shipovnik_message_t *msg) {
+  return verify_absorbed(pk, sig, &msg->hash);
+}
+
+uint64_t shipovnik_message_length(const shipovnik_message_t *msg) {
+  return msg->len;
+}
+
+void shipovnik_message_checkpoint(const shipovnik_message_t *msg,
+                                  uint8_t *checkpoint) {
+  streebog_state_t state;
+  streebog_512_get_state(&msg->hash, &state);
+
+  memset(checkpoint, 0, CHECKPOINT_STATE_OFFSET);
+  memcpy(checkpoint, CHECKPOINT_MAGIC, 4);
+  checkpoint[CHECKPOINT_VERSION_OFFSET] = SHIPOVNIK_CHECKPOINT_VERSION;
+  checkpoint[CHECKPOINT_BUFFERED_OFFSET] = (uint8_t)state.buffered;
+  for (size_t i = 0; i < 8; ++i) {
+    checkpoint[CHECKPOINT_LENGTH_OFFSET + i] =
+        (uint8_t)(msg->len >> (56 - 8 * i));
+  }
+
+  uint8_t *p = checkpoint + CHECKPOINT_STATE_OFFSET;
+  memcpy(p, state.h, GOST_BLOCK_BYTES);
+  memcpy(p + GOST_BLOCK_BYTES, state.n, GOST_BLOCK_BYTES);
+  memcpy(p + 2 * GOST_BLOCK_BYTES, state.sigma, GOST_BLOCK_BYTES);
+  memcpy(p + 3 * GOST_BLOCK_BYTES, state.buffer, GOST_BLOCK_BYTES);
+}
+
+// restores the hash state and the length from a checkpoint
+static int load_checkpoint(const uint8_t *checkpoint, streebog_ctx_t *hash,
+                           uint64_t *len) {
+  if (memcmp(checkpoint, CHECKPOINT_MAGIC, 4) ||
+      checkpoint[CHECKPOINT_VERSION_OFFSET] != SHIPOVNIK_CHECKPOINT_VERSION ||
+      checkpoint[6] != 0 || checkpoint[7] != 0) {
+    return 1;
+  }
+
+  *len = 0;
+  for (size_t i = 0; i < 8; ++i) {
+    *len = (*len << 8) | checkpoint[CHECKPOINT_LENGTH_OFFSET + i];
+  }
+
+  streebog_state_t state;
+  const uint8_t *p = checkpoint + CHECKPOINT_STATE_OFFSET;
+  memcpy(state.h, p, GOST_BLOCK_BYTES);
+  memcpy(state.n, p + GOST_BLOCK_BYTES, GOST_BLOCK_BYTES);
+  memcpy(state.sigma, p + 2 * GOST_BLOCK_BYTES, GOST_BLOCK_BYTES);
+  memcpy(state.buffer, p + 3 * GOST_BLOCK_BYTES, GOST_BLOCK_BYTES);
+  state.buffered = checkpoint[CHECKPOINT_BUFFERED_OFFSET];
+
+  // only whole blocks are compressed, N counts their bits in little endian
+  if (state.buffered != *len % GOST_BLOCK_BYTES) {
+    return 1;
+  }
+  const uint64_t blocks = *len / GOST_BLOCK_BYTES;
+  uint8_t n[GOST_BLOCK_BYTES] = {0};
+  for (size_t i = 0; i < 8; ++i) {
+    n[i] = (uint8_t)((blocks << 9) >> (8 * i));
+  }
+  n[8] = (uint8_t)(blocks >> 55);
+  if (memcmp(n, state.n, GOST_BLOCK_BYTES)) {
+    return 1;
+  }
+  for (size_t i = state.buffered; i < GOST_BLOCK_BYTES; ++i) {
+    if (state.buffer[i] != 0) {
+      return 1;
+    }
+  }
+
+  return streebog_512_set_state(hash, &state);
+}
+
+shipovnik_message_t *shipovnik_message_resume(const uint8_t *checkpoint) {
+  shipovnik_message_t *msg = malloc(sizeof(shipovnik_message_t));
+  if (NULL == msg) {
+    return NULL;
+  }
+  if (load_checkpoint(checkpoint, &msg->hash, &msg->len)) {
+    free(msg);
+    return NULL;
+  }
+  return msg;
+}
+
+int shipovnik_sign_resume(const uint8_t *sk, const uint8_t *checkpoint,
+                          const uint8_t *tail, size_t tail_len, uint8_t *sig,
+                          size_t *sig_len) {
+  shipovnik_message_t msg;
+  if (load_checkpoint(checkpoint, &msg.hash, &msg.len)) {
+    return 1;
+  }
+  shipovnik_message_update(&msg, tail, tail_len);
+  shipovnik_sign_absorbed(sk, &msg, sig, sig_len);
+  return 0;
+}
+
+int shipovnik_verify_resume(const uint8_t *pk, const uint8_t *sig,
+                            const uint8_t *checkpoint, const uint8_t *tail,
+                            size_t tail_len) {
+  shipovnik_message_t msg;
+  if (load_checkpoint(checkpoint, &msg.hash, &msg.len)) {
+    return 1;
+  }
+  shipovnik_message_update(&msg, tail, tail_len);
+  return shipovnik_verify_absorbed(pk, sig, &msg);
+}
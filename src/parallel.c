@@ -0,0 +1,93 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "parallel.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+typedef struct parallel_job_st {
+  parallel_fn_t fn;
+  void *arg;
+  size_t count;
+  size_t grain;
+  atomic_size_t next; // first index of the next chunk to be taken
+} parallel_job_st;
+
+static void parallel_worker(void *p) {
+  parallel_job_st *job = p;
+  for (;;) {
+    const size_t begin = atomic_fetch_add(&job->next, job->grain);
+    if (begin >= job->count) {
+      break;
+    }
+    const size_t end =
+        job->count - begin < job->grain ? job->count : begin + job->grain;
+    job->fn(job->arg, begin, end);
+  }
+}
+
+void parallel_for(shipovnik_executor_t *executor, size_t count, size_t grain,
+                  parallel_fn_t fn, void *arg) {
+  if (count == 0) {
+    return;
+  }
+  if (grain == 0) {
+    grain = 1;
+  }
+
+  parallel_job_st job = {fn, arg, count, grain, 0};
+
+  // no reason to schedule more tasks than there are chunks
+  const size_t chunks = (count + grain - 1) / grain;
+  size_t helpers = executor_concurrency(executor);
+  if (helpers > chunks) {
+    helpers = chunks;
+  }
+  helpers = helpers > 0 ? helpers - 1 : 0;
+
+  void **handles = NULL;
+  size_t submitted = 0;
+  if (helpers > 0) {
+    handles = malloc(helpers * sizeof(void *));
+  }
+  if (handles != NULL) {
+    for (size_t i = 0; i < helpers; ++i) {
+      // chunks of a task that is not scheduled are taken by the others
+      void *handle = executor_submit(executor, parallel_worker, &job);
+      if (handle != NULL) {
+        handles[submitted++] = handle;
+      }
+    }
+  }
+
+  parallel_worker(&job);
+
+  for (size_t i = 0; i < submitted; ++i) {
+    executor_wait(executor, handles[i]);
+  }
+  free(handles);
+}
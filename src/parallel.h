@@ -0,0 +1,74 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "shipovnik.h"
+
+#include <stddef.h>
+
+/**
+ * @brief Body of a parallel loop, processes indices `[begin, end)`.
+ */
+typedef void (*parallel_fn_t)(void *arg, size_t begin, size_t end);
+
+/**
+ * @brief Returns the number of tasks an executor runs in parallel.
+ * @param[in] executor Executor, `NULL` means the calling thread only.
+ */
+size_t executor_concurrency(const shipovnik_executor_t *executor);
+
+/**
+ * @brief Schedules `task(arg)` on an executor.
+ * @param[in] executor Executor.
+ * @param[in] task Task.
+ * @param[in] arg Argument passed to `task`.
+ * @return Handle to be passed to `executor_wait`, or `NULL` if the task is
+ *   not scheduled, e.g. when the queue is full.
+ */
+void *executor_submit(shipovnik_executor_t *executor, shipovnik_task_fn task,
+                      void *arg);
+
+/**
+ * @brief Waits for a scheduled task to complete and releases its handle.
+ * A worker of the executor runs other tasks while waiting.
+ * @param[in] executor Executor the task is scheduled on.
+ * @param[in] handle Handle returned by `executor_submit`.
+ */
+void executor_wait(shipovnik_executor_t *executor, void *handle);
+
+/**
+ * @brief Runs `fn` over `[0, count)` split into chunks of `grain` indices.
+ * Chunks are handed out dynamically to the calling thread and to tasks
+ * scheduled on `executor`. Returns when every chunk is processed.
+ * @param[in] executor Executor, `NULL` means the calling thread only.
+ * @param[in] count Number of indices.
+ * @param[in] grain Number of indices per chunk, `0` is treated as `1`.
+ * @param[in] fn Loop body.
+ * @param[in] arg Argument passed to `fn`.
+ */
+void parallel_for(shipovnik_executor_t *executor, size_t count, size_t grain,
+                  parallel_fn_t fn, void *arg);
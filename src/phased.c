@@ -0,0 +1,185 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "genvector.h"
+#include "hash.h"
+#include "params.h"
+#include "randombytes.h"
+#include "shipovnik.h"
+#include "sign.h"
+#include "syndrome.h"
+#include "utils.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// number of rounds that go through a phase together, buffers of a block
+// (mostly entropy and `sigma || H*u`) stay within L2 cache
+#define PHASE_ROUNDS SYNDROME_LANES
+
+// entropy consumed by a round: u, then shuffle keys for sigma
+#define ROUND_ENTROPY_BYTES (SHIPOVNIK_SECRETKEYBYTES + N * sizeof(uint32_t))
+
+/**
+ * @brief Working memory of a signature, stored as structure of arrays.
+ */
+typedef struct phased_sign_st {
+  // round data kept until the responses are known
+  uint8_t us[DELTA][SHIPOVNIK_SECRETKEYBYTES];
+  uint8_t sigma_ys[DELTA][SIGMA_Y_SIZE]; // packed sigma || H*u
+
+  // buffers of the current block of rounds
+  uint8_t entropy[PHASE_ROUNDS][ROUND_ENTROPY_BYTES];
+  uint16_t sigmas[PHASE_ROUNDS][N];
+  uint8_t u1s[PHASE_ROUNDS][SHIPOVNIK_SECRETKEYBYTES];
+  uint8_t u2s[PHASE_ROUNDS][SHIPOVNIK_SECRETKEYBYTES];
+  uint32_t entropy32[N];
+  uint64_t shuf64[N];
+} phased_sign_st;
+
+// steps 2-3 for rounds [first, first + count)
+static void commit_rounds(const uint8_t *sk, phased_sign_st *st, size_t first,
+                          size_t count, uint8_t *cs) {
+  const uint8_t *us[PHASE_ROUNDS];
+  const uint8_t *sigma_ys[PHASE_ROUNDS];
+  const uint8_t *u1s[PHASE_ROUNDS];
+  const uint8_t *u2s[PHASE_ROUNDS];
+  uint8_t *ys[PHASE_ROUNDS];
+  uint8_t *cis[3][PHASE_ROUNDS];
+
+  // entropy of the whole block at once, in the order of `shipovnik_sign`
+  randombytes(&st->entropy[0][0], count * ROUND_ENTROPY_BYTES);
+
+  for (size_t l = 0; l < count; ++l) {
+    memcpy(st->us[first + l], st->entropy[l], SHIPOVNIK_SECRETKEYBYTES);
+    us[l] = st->us[first + l];
+    sigma_ys[l] = st->sigma_ys[first + l];
+    ys[l] = st->sigma_ys[first + l] + SIGMA_PACKED_BYTES;
+    u1s[l] = st->u1s[l];
+    u2s[l] = st->u2s[l];
+    for (size_t k = 0; k < 3; ++k) {
+      cis[k][l] = cs + ((first + l) * 3 + k) * GOST512_OUTPUT_BYTES;
+    }
+  }
+
+  /* Step 2, all shuffles */
+  for (size_t l = 0; l < count; ++l) {
+    uint16_t *sigma = st->sigmas[l];
+    for (uint16_t j = 0; j < N; ++j) {
+      sigma[j] = j; // init indices
+    }
+    memcpy(st->entropy32, st->entropy[l] + SHIPOVNIK_SECRETKEYBYTES,
+           N * sizeof(uint32_t));
+    shuffle(st->entropy32, sigma, st->shuf64, N);
+  }
+
+  /* Step 3, sigma || H*u of all rounds */
+  for (size_t l = 0; l < count; ++l) {
+    pack_sigma(st->sigmas[l], N, st->sigma_ys[first + l]);
+  }
+  syndrome_batch(H_PRIME, us, ys, count);
+  streebog_512_f_multi(sigma_ys, SIGMA_Y_SIZE, cis[0], count); // ci0
+
+  for (size_t l = 0; l < count; ++l) {
+    apply_permutation(st->sigmas[l], us[l], st->u1s[l], N); // u1 = sigma(u)
+  }
+  streebog_512_f_multi(u1s, SHIPOVNIK_SECRETKEYBYTES, cis[1], count); // ci1
+
+  for (size_t l = 0; l < count; ++l) {
+    bitwise_xor(us[l], sk, SHIPOVNIK_SECRETKEYBYTES, st->u1s[l]);
+    apply_permutation(st->sigmas[l], st->u1s[l], st->u2s[l], N);
+  }
+  streebog_512_f_multi(u2s, SHIPOVNIK_SECRETKEYBYTES, cis[2], count); // ci2
+}
+
+void shipovnik_sign_phased(const uint8_t *sk, const uint8_t *msg,
+                           size_t msg_len, uint8_t *sig, size_t *sig_len) {
+  ALLOC_ON_STACK(uint8_t, h, GOST512_OUTPUT_BYTES);
+  ALLOC_ON_STACK(uint8_t, b, DELTA);
+
+  *sig_len = 0;
+
+  phased_sign_st *const st = malloc(sizeof(phased_sign_st));
+  if (NULL == st) {
+    return;
+  }
+
+  /* Steps 2-3 */
+  for (size_t i = 0; i < DELTA; i += PHASE_ROUNDS) {
+    const size_t count = DELTA - i < PHASE_ROUNDS ? DELTA - i : PHASE_ROUNDS;
+    commit_rounds(sk, st, i, count, sig);
+  }
+
+  /* Step 5 */
+  streebog_ctx_t ctx;
+  streebog_512_init(&ctx);
+  streebog_512_update(&ctx, msg, msg_len);
+  streebog_512_update(&ctx, sig, CS_BYTES);
+  streebog_512_final(&ctx, h);
+
+  /* Steps 6-7 */
+  if (derive_challenge(h, b)) {
+    goto cleanup;
+  }
+
+  /* Step 8, sigma is already packed for b = 0 and b = 1 */
+  uint8_t *rs = sig + CS_BYTES;
+  for (size_t i = 0; i < DELTA; i++) {
+    const uint8_t *u = st->us[i];
+    const uint8_t *packed_sigma = st->sigma_ys[i];
+    uint16_t *sigma = st->sigmas[0];
+    switch (b[i]) {
+    case 0: // sigma_i || u_i
+      memcpy(rs, packed_sigma, SIGMA_PACKED_BYTES);
+      rs += SIGMA_PACKED_BYTES;
+      memcpy(rs, u, SHIPOVNIK_SECRETKEYBYTES);
+      rs += SHIPOVNIK_SECRETKEYBYTES;
+      break;
+    case 1: // sigma_i || (u_i xor s)
+      memcpy(rs, packed_sigma, SIGMA_PACKED_BYTES);
+      rs += SIGMA_PACKED_BYTES;
+      bitwise_xor(u, sk, SHIPOVNIK_SECRETKEYBYTES, rs);
+      rs += SHIPOVNIK_SECRETKEYBYTES;
+      break;
+    case 2: // sigma_i(u_i) || sigma_i(s)
+      unpack_sigma(packed_sigma, SIGMA_PACKED_BYTES, sigma);
+      apply_permutation(sigma, u, rs, N);
+      rs += SHIPOVNIK_SECRETKEYBYTES;
+      apply_permutation(sigma, sk, rs, N);
+      rs += SHIPOVNIK_SECRETKEYBYTES;
+      break;
+    default:
+      goto cleanup;
+    }
+  }
+  *sig_len = rs - sig;
+
+cleanup:
+  // secure sensitive data
+  secure_erase(st, sizeof(phased_sign_st));
+  free(st);
+}
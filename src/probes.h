@@ -0,0 +1,50 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+// USDT probes of the `shipovnik` provider. With `sys/sdt.h` a probe is a NOP
+// instruction and an ELF note, tracers patch it when they attach; otherwise
+// the probes and their arguments compile to nothing.
+#ifdef SHIPOVNIK_USDT
+
+#include <sys/sdt.h>
+
+#define PROBE0(name) DTRACE_PROBE(shipovnik, name)
+#define PROBE1(name, a) DTRACE_PROBE1(shipovnik, name, a)
+#define PROBE2(name, a, b) DTRACE_PROBE2(shipovnik, name, a, b)
+#define PROBE3(name, a, b, c) DTRACE_PROBE3(shipovnik, name, a, b, c)
+
+#else
+
+#define PROBE0(name)                                                           \
+  do {                                                                         \
+  } while (0)
+#define PROBE1(name, a) PROBE0(name)
+#define PROBE2(name, a, b) PROBE0(name)
+#define PROBE3(name, a, b, c) PROBE0(name)
+
+#endif
@@ -25,23 +25,40 @@
 */
 
 #include "randombytes.h"
+#include "stats.h"
 
 #include <errno.h>
 #include <fcntl.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <unistd.h>
 
-void randombytes(uint8_t *out, size_t outlen) {
-  static int fd = -1;
-  ssize_t ret;
+// opens the entropy source once, also when called from several threads
+static int entropy_fd(void) {
+  static atomic_int shared_fd = -1;
 
+  int fd = atomic_load(&shared_fd);
   while (fd == -1) {
     fd = open(ENTROPY_SOURCE, O_RDONLY);
     if (fd == -1 && errno == EINTR)
       continue;
     else if (fd == -1)
       abort();
+
+    int expected = -1;
+    if (!atomic_compare_exchange_strong(&shared_fd, &expected, fd)) {
+      // another thread has opened it first
+      close(fd);
+      fd = expected;
+    }
   }
+  return fd;
+}
+
+void randombytes(uint8_t *out, size_t outlen) {
+  STATS_BEGIN(start);
+  const int fd = entropy_fd();
+  ssize_t ret;
 
   while (outlen > 0) {
     ret = read(fd, out, outlen);
@@ -53,4 +70,5 @@ void randombytes(uint8_t *out, size_t outlen) {
     out += ret;
     outlen -= ret;
   }
+  STATS_END(SHIPOVNIK_PHASE_ENTROPY, start);
 }
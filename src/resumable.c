@@ -0,0 +1,262 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "hash.h"
+#include "params.h"
+#include "shipovnik.h"
+#include "sign.h"
+#include "utils.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum sign_phase_t {
+  SIGN_MESSAGE,   // step 5, hashing of M
+  SIGN_COMMIT,    // steps 2-3
+  SIGN_CHALLENGE, // step 5, hashing of C, steps 6-7
+  SIGN_RESPOND,   // step 8
+  SIGN_DONE,
+  SIGN_FAILED,
+} sign_phase_t;
+
+struct shipovnik_sign_ctx_st {
+  sign_phase_t phase;
+  size_t round; // next round of the phase
+  const uint8_t *sk;
+  const uint8_t *msg;
+  size_t msg_len;
+  size_t msg_pos; // number of message bytes hashed
+  uint8_t *sig;
+  size_t sig_len;
+  streebog_ctx_t hash; // hash(M || C)
+  uint8_t b[DELTA];
+  uint8_t us[DELTA][SHIPOVNIK_SECRETKEYBYTES];
+  uint16_t sigmas[DELTA][N];
+};
+
+typedef enum verify_phase_t {
+  VERIFY_MESSAGE,   // step 1, hashing of M
+  VERIFY_CHALLENGE, // step 1, hashing of C, steps 2-3
+  VERIFY_ROUNDS,    // steps 4-5
+  VERIFY_DONE,
+} verify_phase_t;
+
+struct shipovnik_verify_ctx_st {
+  verify_phase_t phase;
+  size_t round; // next round to check
+  const uint8_t *pk;
+  const uint8_t *sig;
+  const uint8_t *msg;
+  size_t msg_len;
+  size_t msg_pos;    // number of message bytes hashed
+  const uint8_t *ri; // response of the next round
+  int result;
+  streebog_ctx_t hash; // hash(M || C)
+  uint8_t b[DELTA];
+};
+
+// hashes the next slice of a message, returns non-zero when it is hashed
+static int absorb_message(streebog_ctx_t *hash, const uint8_t *msg,
+                          size_t msg_len, size_t *msg_pos) {
+  size_t len = msg_len - *msg_pos;
+  if (len > SHIPOVNIK_STEP_MSG_BYTES) {
+    len = SHIPOVNIK_STEP_MSG_BYTES;
+  }
+  streebog_512_update(hash, msg + *msg_pos, len);
+  *msg_pos += len;
+  return *msg_pos == msg_len;
+}
+
+shipovnik_sign_ctx_t *shipovnik_sign_begin(const uint8_t *sk,
+                                           const uint8_t *msg, size_t msg_len,
+                                           uint8_t *sig) {
+  shipovnik_sign_ctx_t *ctx = malloc(sizeof(shipovnik_sign_ctx_t));
+  if (NULL == ctx) {
+    return NULL;
+  }
+
+  ctx->phase = SIGN_MESSAGE;
+  ctx->round = 0;
+  ctx->sk = sk;
+  ctx->msg = msg;
+  ctx->msg_len = msg_len;
+  ctx->msg_pos = 0;
+  ctx->sig = sig;
+  ctx->sig_len = 0;
+  streebog_512_init(&ctx->hash);
+  return ctx;
+}
+
+int shipovnik_sign_step(shipovnik_sign_ctx_t *ctx, size_t budget_rounds) {
+  ALLOC_ON_STACK(uint8_t, h, GOST512_OUTPUT_BYTES);
+
+  for (; budget_rounds > 0; --budget_rounds) {
+    switch (ctx->phase) {
+    case SIGN_MESSAGE:
+      if (absorb_message(&ctx->hash, ctx->msg, ctx->msg_len, &ctx->msg_pos)) {
+        ctx->phase = SIGN_COMMIT;
+      }
+      break;
+    case SIGN_COMMIT: {
+      const size_t i = ctx->round;
+      uint8_t *ci = ctx->sig + i * 3 * GOST512_OUTPUT_BYTES;
+      sign_round(ctx->sk, ctx->us[i], ctx->sigmas[i], ci);
+      if (++ctx->round == DELTA) {
+        ctx->phase = SIGN_CHALLENGE;
+      }
+      break;
+    }
+    case SIGN_CHALLENGE:
+      streebog_512_update(&ctx->hash, ctx->sig, CS_BYTES);
+      streebog_512_final(&ctx->hash, h);
+      if (derive_challenge(h, ctx->b)) {
+        ctx->phase = SIGN_FAILED;
+        break;
+      }
+      ctx->phase = SIGN_RESPOND;
+      ctx->round = 0;
+      ctx->sig_len = CS_BYTES;
+      break;
+    case SIGN_RESPOND: {
+      const size_t i = ctx->round;
+      const size_t r_len = respond_round(ctx->sk, ctx->us[i], ctx->sigmas[i],
+                                         ctx->b[i], ctx->sig + ctx->sig_len);
+      if (0 == r_len) {
+        ctx->phase = SIGN_FAILED;
+        break;
+      }
+      ctx->sig_len += r_len;
+      if (++ctx->round == DELTA) {
+        ctx->phase = SIGN_DONE;
+      }
+      break;
+    }
+    case SIGN_DONE:
+    case SIGN_FAILED:
+      return 0;
+    }
+  }
+
+  return ctx->phase == SIGN_DONE || ctx->phase == SIGN_FAILED
+             ? 0
+             : SHIPOVNIK_AGAIN;
+}
+
+int shipovnik_sign_finish(shipovnik_sign_ctx_t *ctx, size_t *sig_len) {
+  while (shipovnik_sign_step(ctx, DELTA) == SHIPOVNIK_AGAIN) {
+  }
+
+  const int ret = ctx->phase != SIGN_DONE;
+  *sig_len = ctx->sig_len;
+  shipovnik_sign_cancel(ctx);
+  return ret;
+}
+
+void shipovnik_sign_cancel(shipovnik_sign_ctx_t *ctx) {
+  if (NULL == ctx) {
+    return;
+  }
+  // secure sensitive data
+  secure_erase(ctx, sizeof(shipovnik_sign_ctx_t));
+  free(ctx);
+}
+
+shipovnik_verify_ctx_t *shipovnik_verify_begin(const uint8_t *pk,
+                                               const uint8_t *sig,
+                                               const uint8_t *msg,
+                                               size_t msg_len) {
+  shipovnik_verify_ctx_t *ctx = malloc(sizeof(shipovnik_verify_ctx_t));
+  if (NULL == ctx) {
+    return NULL;
+  }
+
+  ctx->phase = VERIFY_MESSAGE;
+  ctx->round = 0;
+  ctx->pk = pk;
+  ctx->sig = sig;
+  ctx->msg = msg;
+  ctx->msg_len = msg_len;
+  ctx->msg_pos = 0;
+  ctx->ri = sig + CS_BYTES;
+  ctx->result = 1;
+  streebog_512_init(&ctx->hash);
+  return ctx;
+}
+
+int shipovnik_verify_step(shipovnik_verify_ctx_t *ctx, size_t budget_rounds) {
+  ALLOC_ON_STACK(uint8_t, h, GOST512_OUTPUT_BYTES);
+
+  for (; budget_rounds > 0; --budget_rounds) {
+    switch (ctx->phase) {
+    case VERIFY_MESSAGE:
+      if (absorb_message(&ctx->hash, ctx->msg, ctx->msg_len, &ctx->msg_pos)) {
+        ctx->phase = VERIFY_CHALLENGE;
+      }
+      break;
+    case VERIFY_CHALLENGE:
+      streebog_512_update(&ctx->hash, ctx->sig, CS_BYTES);
+      streebog_512_final(&ctx->hash, h);
+      ctx->phase = derive_challenge(h, ctx->b) ? VERIFY_DONE : VERIFY_ROUNDS;
+      break;
+    case VERIFY_ROUNDS: {
+      const size_t i = ctx->round;
+      const uint8_t *ci = ctx->sig + i * 3 * GOST512_OUTPUT_BYTES;
+      if (verify_round(ctx->pk, ctx->b[i], ci, ctx->ri)) {
+        ctx->phase = VERIFY_DONE;
+        break;
+      }
+      ctx->ri += RESPONSE_BYTES(ctx->b[i]);
+      if (++ctx->round == DELTA) {
+        ctx->result = 0;
+        ctx->phase = VERIFY_DONE;
+      }
+      break;
+    }
+    case VERIFY_DONE:
+      return 0;
+    }
+  }
+
+  return ctx->phase == VERIFY_DONE ? 0 : SHIPOVNIK_AGAIN;
+}
+
+int shipovnik_verify_finish(shipovnik_verify_ctx_t *ctx) {
+  while (shipovnik_verify_step(ctx, DELTA) == SHIPOVNIK_AGAIN) {
+  }
+
+  const int ret = ctx->result;
+  shipovnik_verify_cancel(ctx);
+  return ret;
+}
+
+void shipovnik_verify_cancel(shipovnik_verify_ctx_t *ctx) {
+  if (NULL == ctx) {
+    return;
+  }
+  secure_erase(ctx, sizeof(shipovnik_verify_ctx_t));
+  free(ctx);
+}
@@ -28,8 +28,10 @@
 #include "genvector.h"
 #include "hash.h"
 #include "params.h"
+#include "probes.h"
 #include "randombytes.h"
 #include "sign.h"
+#include "stats.h"
 #include "syndrome.h"
 #include "utils.h"
 
@@ -38,6 +40,7 @@
 #include <string.h>
 
 void shipovnik_generate_keys(uint8_t *sk, uint8_t *pk) {
+  STATS_BEGIN(start);
   ALLOC_ON_STACK(uint16_t, s, N);
   gen_vector(s);
   for (size_t i = 0; i < N; ++i) {
@@ -46,19 +49,11 @@ void shipovnik_generate_keys(uint8_t *sk, uint8_t *pk) {
     sk[j] |= s[i] & 1;
   }
   syndrome(H_PRIME, sk, pk);
+  STATS_END(SHIPOVNIK_PHASE_KEYGEN, start);
 }
 
-#define SIGMA_Y_SIZE (SIGMA_PACKED_BYTES + SHIPOVNIK_PUBLICKEYBYTES)
-
-void shipovnik_sign(const uint8_t *sk, const uint8_t *msg, size_t msg_len,
-                    uint8_t *sig, size_t *sig_len) {
-
-  // temporary buffers
-  ALLOC_ON_STACK(uint64_t, shuf64_, N);
-  ALLOC_ON_STACK(uint32_t, entropy32_, N);
-  ALLOC_ON_STACK(uint8_t, sigma_y_, SIGMA_Y_SIZE);
-  ALLOC_ON_STACK(uint8_t, u1_, SHIPOVNIK_SECRETKEYBYTES);
-  ALLOC_ON_STACK(uint8_t, u2_, SHIPOVNIK_SECRETKEYBYTES);
+void sign_absorbed(const uint8_t *sk, const streebog_ctx_t *msg_hash,
+                   uint8_t *sig, size_t *sig_len) {
 
   ALLOC_ON_STACK(uint8_t, h, GOST512_OUTPUT_BYTES);
   ALLOC_ON_STACK(uint8_t, b, DELTA);
@@ -68,54 +63,24 @@ void shipovnik_sign(const uint8_t *sk, const uint8_t *msg, size_t msg_len,
   // array of permutation indices (sigma)
   uint16_t *const sigmas = malloc(DELTA * SIGMA_BYTES);
 
+  /* Steps 2-3 */
   for (size_t i = 0; i < DELTA; i++) {
     uint8_t *u = us + i * SHIPOVNIK_SECRETKEYBYTES;
     uint16_t *sigma = sigmas + i * N;
-    for (uint16_t j = 0; j < N; ++j) {
-      sigma[j] = j; // init indices
-    }
-
-    /* Step 2 */
-    uint8_t *ebytes = (uint8_t *)entropy32_;
-    randombytes(u, SHIPOVNIK_SECRETKEYBYTES);
-    randombytes(ebytes, N * sizeof(uint32_t));
-    // random shuffle permutation indices
-    shuffle(entropy32_, sigma, shuf64_, N);
-
-    /* Step 3 */
     uint8_t *ci = sig + i * 3 * GOST512_OUTPUT_BYTES;
-
-    // sigma_k_ = sigma || H*u
-    pack_sigma(sigma, N, sigma_y_);
-    uint8_t *y = sigma_y_ + SIGMA_PACKED_BYTES;
-    syndrome(H_PRIME, u, y);
-    streebog_512_f(sigma_y_, SIGMA_Y_SIZE, ci); // ci0
-
-    apply_permutation(sigma, u, u1_, N); // u1_ = sigma(u)
-    streebog_512_f(u1_, SHIPOVNIK_SECRETKEYBYTES,
-                   ci + GOST512_OUTPUT_BYTES); // ci1
-
-    bitwise_xor(u, sk, SHIPOVNIK_SECRETKEYBYTES, u1_); // u1_ = u xor sk
-    apply_permutation(sigma, u1_, u2_, N);             // u2_ = sigma(u1_)
-    streebog_512_f(u2_, SHIPOVNIK_SECRETKEYBYTES,
-                   ci + 2 * GOST512_OUTPUT_BYTES); // ci2
+    PROBE1(sign__round__begin, i);
+    sign_round(sk, u, sigma, ci);
+    PROBE1(sign__round__end, i);
   }
 
   /* Step 5 */
-  uint8_t *const msg_cs = malloc(msg_len + CS_BYTES);
-  memcpy(msg_cs, msg, msg_len);
-  memcpy(msg_cs + msg_len, sig, CS_BYTES);
-  streebog_512_f(msg_cs, msg_len + CS_BYTES, h);
-  free(msg_cs);
-
-  /* Step 6 */
-  const multiword_number_t mwh = h_3_delta_shift(h, GOST512_OUTPUT_BYTES);
-  if (NULL == mwh) {
-    goto cleanup;
-  }
+  streebog_ctx_t ctx;
+  streebog_512_copy(&ctx, msg_hash);
+  streebog_512_update(&ctx, sig, CS_BYTES);
+  streebog_512_final(&ctx, h);
 
-  /* Step 7 */
-  if (h_to_ternary_vec(mwh, b, DELTA)) {
+  /* Steps 6-7 */
+  if (derive_challenge(h, b)) {
     goto cleanup;
   }
 
@@ -125,185 +90,79 @@ void shipovnik_sign(const uint8_t *sk, const uint8_t *msg, size_t msg_len,
   for (size_t i = 0; i < DELTA; i++) {
     uint8_t *u = us + i * SHIPOVNIK_SECRETKEYBYTES;
     uint16_t *sigma = sigmas + i * N;
-    switch (b[i]) {
-    case 0: // sigma_i || u_i
-      pack_sigma(sigma, N, rs);
-      rs += SIGMA_PACKED_BYTES;
-      memcpy(rs, u, SHIPOVNIK_SECRETKEYBYTES);
-      rs += SHIPOVNIK_SECRETKEYBYTES;
-      *sig_len += SIGMA_PACKED_BYTES + SHIPOVNIK_SECRETKEYBYTES;
-      break;
-    case 1: // sigma_i || (u_i xor s)
-      pack_sigma(sigma, N, rs);
-      rs += SIGMA_PACKED_BYTES;
-      // u xor sk
-      bitwise_xor(u, sk, SHIPOVNIK_SECRETKEYBYTES, rs);
-      rs += SHIPOVNIK_SECRETKEYBYTES;
-      *sig_len += SIGMA_PACKED_BYTES + SHIPOVNIK_SECRETKEYBYTES;
-      break;
-    case 2: // sigma_i(u_i) || sigma_i(s)
-      apply_permutation(sigma, u, rs, N);
-      rs += SHIPOVNIK_SECRETKEYBYTES;
-      apply_permutation(sigma, sk, rs, N);
-      rs += SHIPOVNIK_SECRETKEYBYTES;
-      *sig_len += 2 * SHIPOVNIK_SECRETKEYBYTES;
-      break;
-    default:
+    const size_t r_len = respond_round(sk, u, sigma, b[i], rs);
+    if (0 == r_len) {
       goto cleanup;
     }
+    rs += r_len;
+    *sig_len += r_len;
   }
 
 cleanup:
   free(us);
   free(sigmas);
-  multiword_number_free(mwh);
 }
 
-int shipovnik_verify(const uint8_t *pk, const uint8_t *sig, const uint8_t *msg,
-                     size_t msg_len) {
-
-  ALLOC_ON_STACK(uint8_t, h, GOST512_OUTPUT_BYTES); // hash_f(buff_MC)
-  ALLOC_ON_STACK(uint8_t, b, DELTA);                // b
-  ALLOC_ON_STACK(uint16_t, sigma, N);
-
-  ALLOC_ON_STACK(uint8_t, sigma_y_, SIGMA_Y_SIZE)         // uint16_t buffer
-  ALLOC_ON_STACK(uint8_t, u_1, SHIPOVNIK_SECRETKEYBYTES); // buffer
-  ALLOC_ON_STACK(uint8_t, cij_, GOST512_OUTPUT_BYTES);    // сi0_, ci1_, ci2_
+void shipovnik_sign(const uint8_t *sk, const uint8_t *msg, size_t msg_len,
+                    uint8_t *sig, size_t *sig_len) {
+  PROBE1(sign__entry, msg_len);
+  STATS_BEGIN(start);
+  streebog_ctx_t msg_hash;
+  streebog_512_init(&msg_hash);
+  PROBE1(message__hash__begin, msg_len);
+  streebog_512_update(&msg_hash, msg, msg_len);
+  PROBE1(message__hash__end, msg_len);
+  sign_absorbed(sk, &msg_hash, sig, sig_len);
+  STATS_END(SHIPOVNIK_PHASE_SIGN, start);
+  PROBE1(sign__return, *sig_len);
+}
 
-  // buf of M||C...
-  const size_t c_border = CS_BYTES; // 3 * delta * GOST512_OUTPUT_BYTES
-  uint8_t *buff_mc = malloc(sizeof(uint8_t) * (msg_len + c_border));
+int verify_absorbed(const uint8_t *pk, const uint8_t *sig,
+                    const streebog_ctx_t *msg_hash) {
 
-  memcpy(buff_mc, msg, msg_len);            // copy M
-  memcpy(buff_mc + msg_len, sig, c_border); // copy C
+  ALLOC_ON_STACK(uint8_t, h, GOST512_OUTPUT_BYTES); // hash_f(M||C)
+  ALLOC_ON_STACK(uint8_t, b, DELTA);                // b
 
   // step 1
-  streebog_512_f(buff_mc, msg_len + c_border, h);
-
-  // step 2
-  int ret = 0;
-  multiword_number_t mwh = h_3_delta_shift(h, GOST512_OUTPUT_BYTES);
-  if (NULL == mwh) {
-    ret = 1;
-    goto cleanup;
+  streebog_ctx_t ctx;
+  streebog_512_copy(&ctx, msg_hash);
+  streebog_512_update(&ctx, sig, CS_BYTES);
+  streebog_512_final(&ctx, h);
+
+  // steps 2-3
+  if (derive_challenge(h, b)) {
+    return 1;
   }
 
-  // step 3
-  if (h_to_ternary_vec(mwh, b, DELTA)) {
-    ret = 1;
-    goto cleanup;
-  }
-
-  const uint8_t *ci0_true = NULL, *ci1_true = NULL, *ci2_true = NULL;
-  const uint8_t *ri0 = NULL, *ri1 = NULL;
   const uint8_t *ci = sig;
-  const uint8_t *ri = sig + c_border;
-  size_t weight = 0;                   // weight of vector
+  const uint8_t *ri = sig + CS_BYTES;
   for (size_t i = 0; i < DELTA; i++) { // step 4
     // step 5
-    ci0_true = ci;
-    ci1_true = ci + GOST512_OUTPUT_BYTES;
-    ci2_true = ci + 2 * GOST512_OUTPUT_BYTES;
-    ci += 3 * GOST512_OUTPUT_BYTES;
-    switch (b[i]) { // step 5.1
-    case 0: {
-      ri0 = ri;
-      ri1 = ri + SIGMA_PACKED_BYTES;
-      ri += SIGMA_PACKED_BYTES + SHIPOVNIK_SECRETKEYBYTES;
-
-      // calculate ci0_
-      memcpy(sigma_y_, ri0, SIGMA_PACKED_BYTES);
-      syndrome(H_PRIME, ri1, sigma_y_ + SIGMA_PACKED_BYTES);
-      streebog_512_f(sigma_y_, SIGMA_Y_SIZE, cij_);
-      if (memcmp(ci0_true, cij_, GOST512_OUTPUT_BYTES)) {
-        ret = 1;
-        goto cleanup;
-      }
-
-      // calculate ci1_
-      if (unpack_sigma(ri0, SIGMA_PACKED_BYTES, sigma) != 0) {
-        ret = 1;
-        goto cleanup;
-      }
-      apply_permutation(sigma, ri1, u_1, N);
-      streebog_512_f(u_1, SHIPOVNIK_SECRETKEYBYTES, cij_);
-
-      if (memcmp(ci1_true, cij_, GOST512_OUTPUT_BYTES)) {
-        ret = 1;
-        goto cleanup;
-      }
-
-      break;
-    }
-    case 1: { // step 5.2
-      ri0 = ri;
-      ri1 = ri + SIGMA_PACKED_BYTES;
-      ri += SIGMA_PACKED_BYTES + SHIPOVNIK_SECRETKEYBYTES;
-
-      // calculate ci0_
-      memcpy(sigma_y_, ri0, SIGMA_PACKED_BYTES);
-      uint8_t *y = sigma_y_ + SIGMA_PACKED_BYTES;
-      syndrome(H_PRIME, ri1, y);
-      bitwise_xor(y, pk, SHIPOVNIK_PUBLICKEYBYTES, y);
-      streebog_512_f(sigma_y_, SIGMA_Y_SIZE, cij_);
-      if (memcmp(ci0_true, cij_, GOST512_OUTPUT_BYTES)) {
-        ret = 1;
-        goto cleanup;
-      }
-
-      // calculate ci2_
-      if (unpack_sigma(ri0, SIGMA_PACKED_BYTES, sigma) != 0) {
-        ret = 1;
-        goto cleanup;
-      }
-      apply_permutation(sigma, ri1, u_1, N);
-      streebog_512_f(u_1, SHIPOVNIK_SECRETKEYBYTES, cij_);
-
-      if (memcmp(ci2_true, cij_, GOST512_OUTPUT_BYTES)) {
-        ret = 1;
-        goto cleanup;
-      }
-
-      break;
-    }
-    case 2: { // step 5.3
-      ri0 = ri;
-      ri1 = ri + SHIPOVNIK_SECRETKEYBYTES;
-      ri += 2 * SHIPOVNIK_SECRETKEYBYTES;
-
-      // calculate ci1_
-      memcpy(u_1, ri0, SHIPOVNIK_SECRETKEYBYTES);
-      streebog_512_f(u_1, SHIPOVNIK_SECRETKEYBYTES, cij_);
-      if (memcmp(ci1_true, cij_, GOST512_OUTPUT_BYTES)) {
-        ret = 1;
-        goto cleanup;
-      }
-
-      // calculate ci2_
-      bitwise_xor(ri0, ri1, SHIPOVNIK_SECRETKEYBYTES, u_1);
-      streebog_512_f(u_1, SHIPOVNIK_SECRETKEYBYTES, cij_);
-      if (memcmp(ci2_true, cij_, GOST512_OUTPUT_BYTES)) {
-        ret = 1;
-        goto cleanup;
-      }
-
-      count_bits(ri1, SHIPOVNIK_SECRETKEYBYTES, &weight);
-      if (W != weight) {
-        ret = 1;
-        goto cleanup;
-      }
-
-      break;
-    }
-    default: {
-      ret = 1;
-      goto cleanup;
-    }
+    PROBE2(verify__round__begin, i, b[i]);
+    const int reason = verify_round(pk, b[i], ci, ri);
+    PROBE3(verify__round__end, i, b[i], reason);
+    if (reason) {
+      PROBE3(verify__fail, i, b[i], reason);
+      return 1;
     }
+    ci += 3 * GOST512_OUTPUT_BYTES;
+    ri += RESPONSE_BYTES(b[i]);
   }
 
-cleanup:
-  free(buff_mc);
-  multiword_number_free(mwh);
-  return ret;
+  return 0;
+}
+
+int shipovnik_verify(const uint8_t *pk, const uint8_t *sig, const uint8_t *msg,
+                     size_t msg_len) {
+  PROBE1(verify__entry, msg_len);
+  STATS_BEGIN(start);
+  streebog_ctx_t msg_hash;
+  streebog_512_init(&msg_hash);
+  PROBE1(message__hash__begin, msg_len);
+  streebog_512_update(&msg_hash, msg, msg_len);
+  PROBE1(message__hash__end, msg_len);
+  const int res = verify_absorbed(pk, sig, &msg_hash);
+  STATS_END(SHIPOVNIK_PHASE_VERIFY, start);
+  PROBE1(verify__return, res);
+  return res;
 }
@@ -25,8 +25,15 @@
 */
 
 #include "sign.h"
+#include "genvector.h"
+#include "hash.h"
 #include "multiword.h"
 #include "params.h"
+#include "probes.h"
+#include "randombytes.h"
+#include "stats.h"
+#include "syndrome.h"
+#include "utils.h"
 #include <string.h>
 
 int pack_sigma(const uint16_t *in, size_t in_len, uint8_t *out) {
@@ -59,6 +66,32 @@ int unpack_sigma(const uint8_t *in, size_t in_len, uint16_t *out) {
   return 0;
 }
 
+#define PERMUTATION_WORDS ((N + 63) / 64)
+
+int check_permutation(const uint16_t *p) {
+  uint64_t seen[PERMUTATION_WORDS] = {0};
+  uint16_t out_of_range = 0;
+
+  for (size_t i = 0; i < N; ++i) {
+    const uint16_t j = p[i];
+    out_of_range |= j >= N;
+    // out of range index marks 0, the result is rejected anyway
+    const uint16_t k = j < N ? j : 0;
+    seen[k / 64] |= (uint64_t)1 << (k % 64);
+  }
+
+  // N distinct indices in range set all the N bits
+  uint64_t missing = 0;
+  for (size_t w = 0; w < N / 64; ++w) {
+    missing |= ~seen[w];
+  }
+#if N % 64
+  missing |= seen[N / 64] ^ (((uint64_t)1 << (N % 64)) - 1);
+#endif
+
+  return (missing != 0) | (out_of_range != 0);
+}
+
 void apply_permutation(const uint16_t *p, const uint8_t *a, uint8_t *buf,
                        size_t len) {
   // iter bits from left to right
@@ -75,6 +108,63 @@ void apply_permutation(const uint16_t *p, const uint8_t *a, uint8_t *buf,
   }
 }
 
+// number of sigma indices packed at once, gives 3 hash blocks
+#define SIGMA_CHUNK 128
+
+void commit_round(const uint8_t *sk, const uint8_t *u, const uint16_t *sigma,
+                  uint8_t *ci) {
+  streebog_ctx_t ctx[3];
+  uint8_t packed[SIGMA_CHUNK * SIGMA_BIT_WIDTH / 8];
+  uint8_t u1[GOST_BLOCK_BYTES]; // block of sigma(u)
+  uint8_t u2[GOST_BLOCK_BYTES]; // block of sigma(u xor sk)
+
+  // ci0 = hash(sigma || H*u), ci1 = hash(sigma(u)),
+  // ci2 = hash(sigma(u) xor sigma(sk)), in one pass over sigma
+  streebog_512_init(&ctx[0]);
+  streebog_512_init(&ctx[1]);
+  streebog_512_init(&ctx[2]);
+  size_t pos = 0;
+  for (size_t i = 0; i < N; i += SIGMA_CHUNK) {
+    const size_t len = N - i < SIGMA_CHUNK ? N - i : SIGMA_CHUNK;
+    pack_sigma(sigma + i, len, packed);
+    streebog_512_update(&ctx[0], packed, len * SIGMA_BIT_WIDTH / 8);
+
+    for (size_t k = i; k < i + len; k += 8) {
+      uint8_t b1 = 0, b2 = 0;
+      for (size_t m = k; m < k + 8; ++m) {
+        const uint16_t j = sigma[m];
+        const uint8_t a_pos = 7 - j % 8; // j-th bit from left
+        const uint8_t bit = (u[j / 8] >> a_pos) & 1;
+        const uint8_t s_bit = (sk[j / 8] >> a_pos) & 1;
+        b1 = (b1 << 1) | bit;
+        b2 = (b2 << 1) | (bit ^ s_bit);
+      }
+      u1[pos] = b1;
+      u2[pos] = b2;
+      if (++pos == GOST_BLOCK_BYTES) {
+        streebog_512_update(&ctx[1], u1, GOST_BLOCK_BYTES);
+        streebog_512_update(&ctx[2], u2, GOST_BLOCK_BYTES);
+        pos = 0;
+      }
+    }
+  }
+  streebog_512_update(&ctx[1], u1, pos);
+  streebog_512_update(&ctx[2], u2, pos);
+  streebog_512_final(&ctx[1], ci + GOST512_OUTPUT_BYTES);
+  streebog_512_final(&ctx[2], ci + 2 * GOST512_OUTPUT_BYTES);
+
+  // the syndrome closes ci0, it is computed whole
+  uint8_t *y = packed;
+  syndrome_batch(H_PRIME, &u, &y, 1);
+  streebog_512_update(&ctx[0], y, SHIPOVNIK_PUBLICKEYBYTES);
+  streebog_512_final(&ctx[0], ci);
+
+  // secure sensitive data
+  SECURE_ERASE(uint8_t, packed, sizeof(packed));
+  SECURE_ERASE(uint8_t, u1, GOST_BLOCK_BYTES);
+  SECURE_ERASE(uint8_t, u2, GOST_BLOCK_BYTES);
+}
+
 // h' = (h * pow(3, delta)) >> 512
 multiword_number_t h_3_delta_shift(const uint8_t *h, size_t h_size) {
 
@@ -164,3 +254,133 @@ int h_to_ternary_vec(multiword_number_t mwh, uint8_t *b, size_t b_size) {
 
   return 0;
 }
+
+int derive_challenge(const uint8_t *h, uint8_t *b) {
+  PROBE0(challenge__begin);
+  STATS_BEGIN(start);
+  const multiword_number_t mwh = h_3_delta_shift(h, GOST512_OUTPUT_BYTES);
+  int ret = 1;
+  if (NULL != mwh) {
+    ret = h_to_ternary_vec(mwh, b, DELTA);
+    multiword_number_free(mwh);
+  }
+  STATS_END(SHIPOVNIK_PHASE_CHALLENGE, start);
+  PROBE1(challenge__end, ret);
+  return ret;
+}
+
+void sign_round(const uint8_t *sk, uint8_t *u, uint16_t *sigma, uint8_t *ci) {
+  ALLOC_ON_STACK(uint64_t, shuf64_, N);
+  ALLOC_ON_STACK(uint32_t, entropy32_, N);
+
+  for (uint16_t j = 0; j < N; ++j) {
+    sigma[j] = j; // init indices
+  }
+
+  /* Step 2 */
+  randombytes(u, SHIPOVNIK_SECRETKEYBYTES);
+  randombytes((uint8_t *)entropy32_, N * sizeof(uint32_t));
+  // random shuffle permutation indices
+  shuffle(entropy32_, sigma, shuf64_, N);
+
+  /* Step 3 */
+  commit_round(sk, u, sigma, ci);
+}
+
+size_t respond_round(const uint8_t *sk, const uint8_t *u,
+                     const uint16_t *sigma, uint8_t b, uint8_t *r) {
+  STATS_BEGIN(start);
+  size_t len = RESPONSE_BYTES(b);
+  switch (b) {
+  case 0: // sigma_i || u_i
+    pack_sigma(sigma, N, r);
+    memcpy(r + SIGMA_PACKED_BYTES, u, SHIPOVNIK_SECRETKEYBYTES);
+    break;
+  case 1: // sigma_i || (u_i xor s)
+    pack_sigma(sigma, N, r);
+    bitwise_xor(u, sk, SHIPOVNIK_SECRETKEYBYTES, r + SIGMA_PACKED_BYTES);
+    break;
+  case 2: // sigma_i(u_i) || sigma_i(s)
+    apply_permutation(sigma, u, r, N);
+    apply_permutation(sigma, sk, r + SHIPOVNIK_SECRETKEYBYTES, N);
+    break;
+  default:
+    len = 0;
+    break;
+  }
+  STATS_END(SHIPOVNIK_PHASE_RESPONSE, start);
+  return len;
+}
+
+int verify_round(const uint8_t *pk, uint8_t b, const uint8_t *ci,
+                 const uint8_t *ri) {
+  ALLOC_ON_STACK(uint16_t, sigma, N);
+  ALLOC_ON_STACK(uint8_t, sigma_y_, SIGMA_Y_SIZE);
+  ALLOC_ON_STACK(uint8_t, u_1, SHIPOVNIK_SECRETKEYBYTES);
+  ALLOC_ON_STACK(uint8_t, cij_, GOST512_OUTPUT_BYTES); // сi0_, ci1_, ci2_
+
+  const uint8_t *ci0_true = ci;
+  const uint8_t *ci1_true = ci + GOST512_OUTPUT_BYTES;
+  const uint8_t *ci2_true = ci + 2 * GOST512_OUTPUT_BYTES;
+
+  switch (b) {
+  case 0:   // step 5.1
+  case 1: { // step 5.2
+    const uint8_t *ri0 = ri;
+    const uint8_t *ri1 = ri + SIGMA_PACKED_BYTES;
+
+    if (unpack_sigma(ri0, SIGMA_PACKED_BYTES, sigma) != 0 ||
+        check_permutation(sigma) != 0) {
+      return ROUND_BAD_PERMUTATION;
+    }
+
+    // calculate ci0_
+    memcpy(sigma_y_, ri0, SIGMA_PACKED_BYTES);
+    uint8_t *y = sigma_y_ + SIGMA_PACKED_BYTES;
+    syndrome(H_PRIME, ri1, y);
+    if (b == 1) {
+      bitwise_xor(y, pk, SHIPOVNIK_PUBLICKEYBYTES, y);
+    }
+    streebog_512_f(sigma_y_, SIGMA_Y_SIZE, cij_);
+    if (memcmp(ci0_true, cij_, GOST512_OUTPUT_BYTES)) {
+      return ROUND_BAD_CI0;
+    }
+
+    // calculate ci1_ for b = 0, ci2_ for b = 1
+    apply_permutation(sigma, ri1, u_1, N);
+    streebog_512_f(u_1, SHIPOVNIK_SECRETKEYBYTES, cij_);
+    if (memcmp(b == 0 ? ci1_true : ci2_true, cij_, GOST512_OUTPUT_BYTES)) {
+      return b == 0 ? ROUND_BAD_CI1 : ROUND_BAD_CI2;
+    }
+
+    return 0;
+  }
+  case 2: { // step 5.3
+    const uint8_t *ri0 = ri;
+    const uint8_t *ri1 = ri + SHIPOVNIK_SECRETKEYBYTES;
+
+    size_t weight = 0; // weight of vector
+    count_bits(ri1, SHIPOVNIK_SECRETKEYBYTES, &weight);
+    if (W != weight) {
+      return ROUND_BAD_WEIGHT;
+    }
+
+    // calculate ci1_
+    streebog_512_f(ri0, SHIPOVNIK_SECRETKEYBYTES, cij_);
+    if (memcmp(ci1_true, cij_, GOST512_OUTPUT_BYTES)) {
+      return ROUND_BAD_CI1;
+    }
+
+    // calculate ci2_
+    bitwise_xor(ri0, ri1, SHIPOVNIK_SECRETKEYBYTES, u_1);
+    streebog_512_f(u_1, SHIPOVNIK_SECRETKEYBYTES, cij_);
+    if (memcmp(ci2_true, cij_, GOST512_OUTPUT_BYTES)) {
+      return ROUND_BAD_CI2;
+    }
+
+    return 0;
+  }
+  default:
+    return ROUND_BAD_CHALLENGE;
+  }
+}
@@ -26,11 +26,21 @@
 
 #pragma once
 
+#include "hash.h"
 #include "multiword.h"
+#include "params.h"
 
 #include <stddef.h>
 #include <stdint.h>
 
+// size of packed sigma concatenated with a syndrome, the input of ci0 hash
+#define SIGMA_Y_SIZE (SIGMA_PACKED_BYTES + SHIPOVNIK_PUBLICKEYBYTES)
+
+// size of the response of a round with challenge `b`
+#define RESPONSE_BYTES(b)                                                      \
+  ((b) == 2 ? 2 * SHIPOVNIK_SECRETKEYBYTES                                     \
+            : SIGMA_PACKED_BYTES + SHIPOVNIK_SECRETKEYBYTES)
+
 /**
  * @brief Pack permutation indices into bytes in big endian order, bit packing
  * width is 12. [0x0C1A, 0x02F9] -> [0xC1, 0xA2, 0xF9]
@@ -51,6 +61,15 @@ int pack_sigma(const uint16_t *in, size_t in_len, uint8_t *out);
  */
 int unpack_sigma(const uint8_t *in, size_t in_len, uint16_t *out);
 
+/**
+ * @brief Checks that indices are a permutation of `[0, N)`. Marks seen
+ * indices in a scalar bitmap, one index at a time, then tests it word by
+ * word.
+ * @param[in] p indices of size `N`
+ * @return 0 if `p` is a permutation, otherwise 1
+ */
+int check_permutation(const uint16_t *p);
+
 /**
  * @brief Permutate bits according to indices.
  * @param[in] p permutation indices
@@ -61,6 +80,22 @@ int unpack_sigma(const uint8_t *in, size_t in_len, uint16_t *out);
 void apply_permutation(const uint16_t *p, const uint8_t *a, uint8_t *buf,
                        size_t len);
 
+/**
+ * @brief Computes step 3 of Shipovnik sign algorithm for one round: the
+ * commitments ci0 = hash(sigma || H*u), ci1 = hash(sigma(u)) and
+ * ci2 = hash(sigma(u xor sk)). One pass over sigma feeds three live hash
+ * contexts: every 128 indices are packed into three blocks of ci0, and the
+ * permuted vectors go to ci1 and ci2 a 64-byte block at a time. The syndrome,
+ * which closes ci0, is computed whole into a 181-byte buffer afterwards.
+ * @param[in] sk secret key of size `SHIPOVNIK_SECRETKEYBYTES`
+ * @param[in] u random vector of size `SHIPOVNIK_SECRETKEYBYTES`
+ * @param[in] sigma permutation indices of size `N`
+ * @param[out] ci commitments ci0 || ci1 || ci2, of size
+ *   `3 * GOST512_OUTPUT_BYTES`
+ */
+void commit_round(const uint8_t *sk, const uint8_t *u, const uint16_t *sigma,
+                  uint8_t *ci);
+
 /**
  * @brief Computes step 6 of Shipovnik sign algorithm
  * @param[in] h hash bytes, that are interpreted as a multiword number
@@ -78,3 +113,79 @@ multiword_number_t h_3_delta_shift(const uint8_t *h, size_t h_size);
  * @return 0 if Ok, 1 if division error occurred
  */
 int h_to_ternary_vec(multiword_number_t mwh, uint8_t *b, size_t b_size);
+
+/**
+ * @brief Computes steps 6 and 7 of Shipovnik sign algorithm
+ * @param[in] h hash of `M || C`, of size `GOST512_OUTPUT_BYTES`
+ * @param[out] b challenges, ternary vector of size `DELTA`
+ * @return 0 if Ok, 1 if an allocation or division error occurred
+ */
+int derive_challenge(const uint8_t *h, uint8_t *b);
+
+/**
+ * @brief Computes steps 2 and 3 of Shipovnik sign algorithm for one round:
+ * draws random vector u and permutation sigma, and commits to them.
+ * @param[in] sk secret key of size `SHIPOVNIK_SECRETKEYBYTES`
+ * @param[out] u random vector of size `SHIPOVNIK_SECRETKEYBYTES`
+ * @param[out] sigma permutation indices of size `N`
+ * @param[out] ci commitments ci0 || ci1 || ci2, of size
+ *   `3 * GOST512_OUTPUT_BYTES`
+ */
+void sign_round(const uint8_t *sk, uint8_t *u, uint16_t *sigma, uint8_t *ci);
+
+/**
+ * @brief Computes step 8 of Shipovnik sign algorithm for one round.
+ * @param[in] sk secret key of size `SHIPOVNIK_SECRETKEYBYTES`
+ * @param[in] u random vector of the round
+ * @param[in] sigma permutation indices of the round
+ * @param[in] b challenge of the round
+ * @param[out] r response of size `RESPONSE_BYTES(b)`
+ * @return size of the response, 0 if `b` is not a ternary digit
+ */
+size_t respond_round(const uint8_t *sk, const uint8_t *u,
+                     const uint16_t *sigma, uint8_t b, uint8_t *r);
+
+// reasons of a round rejected by `verify_round`
+#define ROUND_BAD_CHALLENGE 1   // `b` is not a ternary digit
+#define ROUND_BAD_PERMUTATION 2 // sigma is not a permutation
+#define ROUND_BAD_WEIGHT 3      // the vector is not of weight `W`
+#define ROUND_BAD_CI0 4         // ci0 does not match
+#define ROUND_BAD_CI1 5         // ci1 does not match
+#define ROUND_BAD_CI2 6         // ci2 does not match
+
+/**
+ * @brief Computes step 5 of Shipovnik verify algorithm for one round.
+ * @param[in] pk public key of size `SHIPOVNIK_PUBLICKEYBYTES`
+ * @param[in] b challenge of the round
+ * @param[in] ci commitments ci0 || ci1 || ci2 of the round
+ * @param[in] ri response of the round, of size `RESPONSE_BYTES(b)`
+ * @return 0 if the response matches the commitments, otherwise the reason,
+ *   one of `ROUND_BAD_*`. Cheap checks of the response (permutation, weight)
+ *   are done before hashing.
+ */
+int verify_round(const uint8_t *pk, uint8_t b, const uint8_t *ci,
+                 const uint8_t *ri);
+
+/**
+ * @brief Generates signature of the message absorbed by `msg_hash`, same as
+ * `shipovnik_sign`.
+ * @param[in] sk secret key of size `SHIPOVNIK_SECRETKEYBYTES`
+ * @param[in] msg_hash context that absorbed the message, it is copied, so it
+ *   may be used again
+ * @param[out] sig signature of size `SHIPOVNIK_SIGBYTES`
+ * @param[out] sig_len size of the signature
+ */
+void sign_absorbed(const uint8_t *sk, const streebog_ctx_t *msg_hash,
+                   uint8_t *sig, size_t *sig_len);
+
+/**
+ * @brief Verifies signature of the message absorbed by `msg_hash`, same as
+ * `shipovnik_verify`.
+ * @param[in] pk public key of size `SHIPOVNIK_PUBLICKEYBYTES`
+ * @param[in] sig signature
+ * @param[in] msg_hash context that absorbed the message, it is copied, so it
+ *   may be used again
+ * @return 0 if the signature is valid, otherwise 1
+ */
+int verify_absorbed(const uint8_t *pk, const uint8_t *sig,
+                    const streebog_ctx_t *msg_hash);
@@ -0,0 +1,103 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "hash.h"
+#include "params.h"
+#include "shipovnik.h"
+#include "sign.h"
+#include "utils.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+int shipovnik_sign_to(const uint8_t *sk, const uint8_t *msg, size_t msg_len,
+                      const shipovnik_sign_sink_t *sink, size_t *sig_len) {
+  ALLOC_ON_STACK(uint8_t, h, GOST512_OUTPUT_BYTES);
+  ALLOC_ON_STACK(uint8_t, b, DELTA);
+  int ret = 1;
+  *sig_len = 0;
+
+  // commitments, then the response being written
+  uint8_t *const cs = malloc(CS_BYTES + RESPONSE_BYTES(0));
+  // array of random bit vectors (u)
+  uint8_t *const us = malloc(DELTA * SHIPOVNIK_SECRETKEYBYTES);
+  // array of permutation indices (sigma)
+  uint16_t *const sigmas = malloc(DELTA * SIGMA_BYTES);
+  if (NULL == cs || NULL == us || NULL == sigmas) {
+    goto cleanup;
+  }
+
+  /* Steps 2-3 */
+  for (size_t i = 0; i < DELTA; i++) {
+    sign_round(sk, us + i * SHIPOVNIK_SECRETKEYBYTES, sigmas + i * N,
+               cs + i * 3 * GOST512_OUTPUT_BYTES);
+  }
+
+  // C is final, so it leaves before the message is hashed
+  if (sink->write(sink->ctx, cs, CS_BYTES)) {
+    goto cleanup;
+  }
+  *sig_len = CS_BYTES;
+
+  /* Step 5 */
+  streebog_ctx_t ctx;
+  streebog_512_init(&ctx);
+  streebog_512_update(&ctx, msg, msg_len);
+  streebog_512_update(&ctx, cs, CS_BYTES);
+  streebog_512_final(&ctx, h);
+
+  /* Steps 6-7 */
+  if (derive_challenge(h, b)) {
+    goto cleanup;
+  }
+
+  /* Step 8 */
+  uint8_t *const r = cs + CS_BYTES;
+  for (size_t i = 0; i < DELTA; i++) {
+    const size_t r_len = respond_round(sk, us + i * SHIPOVNIK_SECRETKEYBYTES,
+                                       sigmas + i * N, b[i], r);
+    if (0 == r_len || sink->write(sink->ctx, r, r_len)) {
+      goto cleanup;
+    }
+    *sig_len += r_len;
+  }
+  ret = 0;
+
+cleanup:
+  if (NULL != cs) {
+    secure_erase(cs + CS_BYTES, RESPONSE_BYTES(0));
+  }
+  if (NULL != us) {
+    secure_erase(us, DELTA * SHIPOVNIK_SECRETKEYBYTES);
+  }
+  if (NULL != sigmas) {
+    secure_erase(sigmas, DELTA * SIGMA_BYTES);
+  }
+  free(cs);
+  free(us);
+  free(sigmas);
+  return ret;
+}
@@ -0,0 +1,176 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "stats.h"
+#include "shipovnik.h"
+
+#include <string.h>
+
+static const char *const phase_names[SHIPOVNIK_PHASES] = {
+    "keygen",   "sign", "verify",    "entropy", "shuffle",
+    "syndrome", "hash", "challenge", "response"};
+
+const char *shipovnik_phase_name(int phase) {
+  return phase >= 0 && phase < SHIPOVNIK_PHASES ? phase_names[phase] : NULL;
+}
+
+#ifdef SHIPOVNIK_STATS
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TICKS_ARE_CYCLES 1
+#else
+#define TICKS_ARE_CYCLES 0
+#endif
+
+/**
+ * @brief Counters of a thread. Only the owner writes them, so updates are
+ * plain relaxed stores; blocks of exited threads are kept with their counts
+ * and reused by new threads.
+ */
+typedef struct stats_block_st {
+  _Atomic uint64_t calls[SHIPOVNIK_PHASES];
+  _Atomic uint64_t ticks[SHIPOVNIK_PHASES];
+  _Atomic uint64_t buckets[SHIPOVNIK_PHASES][SHIPOVNIK_STATS_BUCKETS];
+  atomic_int owned;
+  struct stats_block_st *next;
+} stats_block_t;
+
+static atomic_int enabled = 0;
+static _Atomic(stats_block_t *) blocks = NULL;
+static _Thread_local stats_block_t *current = NULL;
+static pthread_key_t release_key;
+static pthread_once_t release_once = PTHREAD_ONCE_INIT;
+
+static void release(void *block) {
+  atomic_store(&((stats_block_t *)block)->owned, 0);
+}
+
+static void create_release_key(void) {
+  pthread_key_create(&release_key, release);
+}
+
+static stats_block_t *acquire(void) {
+  stats_block_t *block = atomic_load(&blocks);
+  for (; NULL != block; block = block->next) {
+    int expected = 0;
+    if (atomic_compare_exchange_strong(&block->owned, &expected, 1)) {
+      break;
+    }
+  }
+  if (NULL == block) {
+    block = calloc(1, sizeof(stats_block_t));
+    if (NULL == block) {
+      return NULL;
+    }
+    atomic_init(&block->owned, 1);
+    block->next = atomic_load(&blocks);
+    while (!atomic_compare_exchange_weak(&blocks, &block->next, block)) {
+    }
+  }
+  pthread_once(&release_once, create_release_key);
+  pthread_setspecific(release_key, block);
+  return block;
+}
+
+static inline uint64_t ticks(void) {
+#if TICKS_ARE_CYCLES
+  return __rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static inline void add(_Atomic uint64_t *counter, uint64_t value) {
+  atomic_store_explicit(
+      counter, atomic_load_explicit(counter, memory_order_relaxed) + value,
+      memory_order_relaxed);
+}
+
+uint64_t stats_begin(void) {
+  if (!atomic_load_explicit(&enabled, memory_order_relaxed)) {
+    return 0;
+  }
+  return ticks();
+}
+
+void stats_end(int phase, uint64_t start) {
+  if (0 == start) {
+    return;
+  }
+  const uint64_t elapsed = ticks() - start;
+  if (NULL == current && NULL == (current = acquire())) {
+    return;
+  }
+  const int bucket = elapsed ? 63 - __builtin_clzll(elapsed) : 0;
+  add(&current->calls[phase], 1);
+  add(&current->ticks[phase], elapsed);
+  add(&current->buckets[phase][bucket], 1);
+}
+
+int shipovnik_stats_enable(int on) {
+  atomic_store(&enabled, 0 != on);
+  return 0;
+}
+
+void shipovnik_stats_snapshot(shipovnik_stats_t *stats) {
+  memset(stats, 0, sizeof(*stats));
+  stats->ticks_are_cycles = TICKS_ARE_CYCLES;
+  for (stats_block_t *block = atomic_load(&blocks); NULL != block;
+       block = block->next) {
+    for (int p = 0; p < SHIPOVNIK_PHASES; ++p) {
+      shipovnik_phase_stats_t *phase = &stats->phases[p];
+      phase->calls +=
+          atomic_load_explicit(&block->calls[p], memory_order_relaxed);
+      phase->ticks +=
+          atomic_load_explicit(&block->ticks[p], memory_order_relaxed);
+      for (int b = 0; b < SHIPOVNIK_STATS_BUCKETS; ++b) {
+        phase->buckets[b] +=
+            atomic_load_explicit(&block->buckets[p][b], memory_order_relaxed);
+      }
+    }
+  }
+}
+
+#else
+
+int shipovnik_stats_enable(int on) {
+  (void)on;
+  return 1;
+}
+
+void shipovnik_stats_snapshot(shipovnik_stats_t *stats) {
+  memset(stats, 0, sizeof(*stats));
+}
+
+#endif
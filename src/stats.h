@@ -0,0 +1,58 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "phases.h"
+
+#include <stdint.h>
+
+#ifdef SHIPOVNIK_STATS
+
+/**
+ * @brief Starts timing a phase.
+ *
+ * @return The start tick, `0` if the instrumentation is off.
+ */
+uint64_t stats_begin(void);
+
+/**
+ * @brief Accounts a phase started by `stats_begin` to the calling thread.
+ *
+ * @param[in] phase Phase, one of `SHIPOVNIK_PHASE_*`.
+ * @param[in] start The start tick, the phase is skipped if it is `0`.
+ */
+void stats_end(int phase, uint64_t start);
+
+#define STATS_BEGIN(start) const uint64_t start = stats_begin()
+#define STATS_END(phase, start) stats_end(phase, start)
+
+#else
+
+#define STATS_BEGIN(start)
+#define STATS_END(phase, start)
+
+#endif
@@ -0,0 +1,139 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "hash.h"
+#include "params.h"
+#include "shipovnik.h"
+#include "sign.h"
+#include "utils.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum stream_phase_t {
+  STREAM_MESSAGE,     // step 1, hashing of M
+  STREAM_COMMITMENTS, // step 1, buffering and hashing of C
+  STREAM_RESPONSES,   // steps 4-5
+  STREAM_DONE,        // all the rounds are checked
+  STREAM_FAILED,
+} stream_phase_t;
+
+struct shipovnik_verify_stream_st {
+  stream_phase_t phase;
+  size_t round; // round of the buffered response
+  size_t fill;  // number of bytes in the buffer of the phase
+  uint8_t pk[SHIPOVNIK_PUBLICKEYBYTES];
+  streebog_ctx_t hash; // hash(M || C)
+  uint8_t b[DELTA];
+  uint8_t cs[CS_BYTES];
+  uint8_t response[RESPONSE_BYTES(0)];
+};
+
+shipovnik_verify_stream_t *shipovnik_verify_stream_begin(const uint8_t *pk) {
+  shipovnik_verify_stream_t *ctx = malloc(sizeof(shipovnik_verify_stream_t));
+  if (NULL == ctx) {
+    return NULL;
+  }
+
+  ctx->phase = STREAM_MESSAGE;
+  ctx->round = 0;
+  ctx->fill = 0;
+  memcpy(ctx->pk, pk, SHIPOVNIK_PUBLICKEYBYTES);
+  streebog_512_init(&ctx->hash);
+  return ctx;
+}
+
+void shipovnik_verify_stream_message(shipovnik_verify_stream_t *ctx,
+                                     const uint8_t *part, size_t len) {
+  if (STREAM_MESSAGE == ctx->phase) {
+    streebog_512_update(&ctx->hash, part, len);
+  } else {
+    ctx->phase = STREAM_FAILED;
+  }
+}
+
+// copies up to `want - *fill` bytes of the input into `buf`
+static size_t take(uint8_t *buf, size_t want, size_t *fill,
+                   const uint8_t **part, size_t *len) {
+  size_t n = want - *fill;
+  if (n > *len) {
+    n = *len;
+  }
+  memcpy(buf + *fill, *part, n);
+  *fill += n;
+  *part += n;
+  *len -= n;
+  return *fill == want;
+}
+
+int shipovnik_verify_stream_signature(shipovnik_verify_stream_t *ctx,
+                                      const uint8_t *part, size_t len) {
+  if (STREAM_MESSAGE == ctx->phase) {
+    ctx->phase = STREAM_COMMITMENTS;
+  }
+
+  if (STREAM_COMMITMENTS == ctx->phase &&
+      take(ctx->cs, CS_BYTES, &ctx->fill, &part, &len)) {
+    ALLOC_ON_STACK(uint8_t, h, GOST512_OUTPUT_BYTES);
+    streebog_512_update(&ctx->hash, ctx->cs, CS_BYTES);
+    streebog_512_final(&ctx->hash, h);
+    // steps 2-3
+    ctx->phase = derive_challenge(h, ctx->b) ? STREAM_FAILED : STREAM_RESPONSES;
+    ctx->fill = 0;
+  }
+
+  while (STREAM_RESPONSES == ctx->phase && len > 0) {
+    const uint8_t b = ctx->b[ctx->round];
+    if (!take(ctx->response, RESPONSE_BYTES(b), &ctx->fill, &part, &len)) {
+      break;
+    }
+    const uint8_t *ci = ctx->cs + ctx->round * 3 * GOST512_OUTPUT_BYTES;
+    if (verify_round(ctx->pk, b, ci, ctx->response)) {
+      ctx->phase = STREAM_FAILED;
+    } else if (++ctx->round == DELTA) {
+      ctx->phase = STREAM_DONE;
+    }
+    ctx->fill = 0;
+  }
+
+  // bytes past the last response
+  if (STREAM_DONE == ctx->phase && len > 0) {
+    ctx->phase = STREAM_FAILED;
+  }
+
+  return STREAM_FAILED == ctx->phase;
+}
+
+int shipovnik_verify_stream_finish(shipovnik_verify_stream_t *ctx) {
+  const int result = STREAM_DONE != ctx->phase;
+  shipovnik_verify_stream_cancel(ctx);
+  return result;
+}
+
+void shipovnik_verify_stream_cancel(shipovnik_verify_stream_t *ctx) {
+  free(ctx);
+}
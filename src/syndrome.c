@@ -26,6 +26,7 @@
 
 #include "syndrome.h"
 #include "params.h"
+#include "stats.h"
 
 #include <string.h>
 
@@ -64,6 +65,7 @@ static inline uint8_t dot_product(const uint8_t *l, const uint8_t *r,
 }
 
 void syndrome(const uint8_t *H_prime, const uint8_t *sk, uint8_t *pk) {
+  STATS_BEGIN(start);
 
   uint8_t row[N_BYTES];
   memset(row + PRIME_ROW_BYTES, 0, K_BYTES);
@@ -85,4 +87,74 @@ void syndrome(const uint8_t *H_prime, const uint8_t *sk, uint8_t *pk) {
     // move to next row
     H_prime += PRIME_ROW_BYTES;
   }
+  STATS_END(SHIPOVNIK_PHASE_SYNDROME, start);
+}
+
+#define PRIME_ROW_WORDS (PRIME_ROW_BYTES / sizeof(uint64_t))
+#define PRIME_ROW_TAIL (PRIME_ROW_BYTES % sizeof(uint64_t))
+
+static inline uint64_t load_word(const uint8_t *p, size_t len) {
+  uint64_t w = 0;
+  memcpy(&w, p, len);
+  return w;
+}
+
+static inline uint8_t parity(uint64_t w) {
+  w ^= w >> 32;
+  w ^= w >> 16;
+  w ^= w >> 8;
+  w ^= w >> 4;
+  w ^= w >> 2;
+  w ^= w >> 1;
+  return w & 1;
+}
+
+void syndrome_batch(const uint8_t *H_prime, const uint8_t *const *vs,
+                    uint8_t *const *ss, size_t count) {
+  STATS_BEGIN(start);
+  // H' part of the vectors as words, the tail is zero padded
+  uint64_t v[SYNDROME_LANES][PRIME_ROW_WORDS + 1];
+
+  for (size_t first = 0; first < count; first += SYNDROME_LANES) {
+    const size_t lanes =
+        count - first < SYNDROME_LANES ? count - first : SYNDROME_LANES;
+    const uint8_t *const *lvs = vs + first;
+    uint8_t *const *lss = ss + first;
+
+    for (size_t l = 0; l < lanes; ++l) {
+      for (size_t j = 0; j < PRIME_ROW_WORDS; ++j) {
+        v[l][j] = load_word(lvs[l] + j * sizeof(uint64_t), sizeof(uint64_t));
+      }
+      v[l][PRIME_ROW_WORDS] = load_word(
+          lvs[l] + PRIME_ROW_WORDS * sizeof(uint64_t), PRIME_ROW_TAIL);
+    }
+
+    const uint8_t *row = H_prime;
+    for (uint32_t i = 0; i < K; i += 8) {
+      uint8_t bytes[SYNDROME_LANES] = {0};
+      for (uint32_t bit = 0; bit < 8; ++bit) {
+        uint64_t acc[SYNDROME_LANES] = {0};
+        // every word of the row is loaded once for all the vectors
+        for (size_t j = 0; j < PRIME_ROW_WORDS; ++j) {
+          const uint64_t h = load_word(row + j * sizeof(uint64_t),
+                                       sizeof(uint64_t));
+          for (size_t l = 0; l < lanes; ++l) {
+            acc[l] ^= h & v[l][j];
+          }
+        }
+        const uint64_t h = load_word(row + PRIME_ROW_WORDS * sizeof(uint64_t),
+                                     PRIME_ROW_TAIL);
+        for (size_t l = 0; l < lanes; ++l) {
+          acc[l] ^= h & v[l][PRIME_ROW_WORDS];
+          bytes[l] = (bytes[l] << 1) | parity(acc[l]);
+        }
+        row += PRIME_ROW_BYTES;
+      }
+      // identity part of the row selects bits of the right half of a vector
+      for (size_t l = 0; l < lanes; ++l) {
+        lss[l][i / 8] = bytes[l] ^ lvs[l][PRIME_ROW_BYTES + i / 8];
+      }
+    }
+  }
+  STATS_END(SHIPOVNIK_PHASE_SYNDROME, start);
 }
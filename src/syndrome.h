@@ -26,8 +26,12 @@
 
 #pragma once
 
+#include "stddef.h"
 #include "stdint.h"
 
+// number of vectors processed per pass over H' by `syndrome_batch`
+#define SYNDROME_LANES 8
+
 /**
  * @brief Compute pubkey from matrix H' and secret key.
  * @param[in] H_prime The H' matrix.
@@ -35,3 +39,15 @@
  * @param[out] pk Public key of size `SHIPOVNIK_PUBLICKEYBYTES`.
  */
 void syndrome(const uint8_t *H_prime, const uint8_t *sk, uint8_t *pk);
+
+/**
+ * @brief Compute syndromes of several vectors with one pass over matrix H'
+ * per `SYNDROME_LANES` vectors. Gives the same result as calling `syndrome`
+ * for every vector.
+ * @param[in] H_prime The H' matrix.
+ * @param[in] vs Vectors of size `SHIPOVNIK_SECRETKEYBYTES`.
+ * @param[out] ss Syndromes of size `SHIPOVNIK_PUBLICKEYBYTES`.
+ * @param[in] count Number of vectors.
+ */
+void syndrome_batch(const uint8_t *H_prime, const uint8_t *const *vs,
+                    uint8_t *const *ss, size_t count);
@@ -0,0 +1,302 @@
+/*
+   This product is distributed under 2-term BSD-license terms
+
+   Copyright (c) 2023, QApp. All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met: 
+
+   1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer. 
+   2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution. 
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "hash.h"
+#include "params.h"
+#include "shipovnik.h"
+#include "utils.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// marks the end of a bucket chain
+#define NO_ENTRY -1
+
+typedef struct cache_entry_st {
+  uint8_t key[GOST512_OUTPUT_BYTES];
+  uint64_t pk_tag; // first bytes of the public key
+  int32_t next;    // next entry in the same bucket
+  int result;
+  uint8_t used;
+  uint8_t referenced;
+} cache_entry_st;
+
+typedef struct cache_shard_st {
+  pthread_mutex_t lock;
+  cache_entry_st *entries;
+  size_t count;
+  size_t hand; // CLOCK hand
+  int32_t *buckets;
+  size_t bucket_mask;
+  shipovnik_verify_cache_stats_t stats;
+} cache_shard_st;
+
+struct shipovnik_verify_cache_st {
+  cache_shard_st *shards;
+  size_t shard_count;
+  int store_failures;
+};
+
+static uint64_t load_u64(const uint8_t *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static size_t round_up_pow2(size_t n) {
+  size_t p = 1;
+  while (p < n) {
+    p <<= 1;
+  }
+  return p;
+}
+
+// the key is uniform, so its first words select the shard and the bucket
+static cache_shard_st *shard_of(shipovnik_verify_cache_t *cache,
+                                const uint8_t *key) {
+  return &cache->shards[load_u64(key) % cache->shard_count];
+}
+
+static int32_t *bucket_of(cache_shard_st *s, const uint8_t *key) {
+  return &s->buckets[load_u64(key + 8) & s->bucket_mask];
+}
+
+static cache_entry_st *find(cache_shard_st *s, const uint8_t *key) {
+  for (int32_t i = *bucket_of(s, key); i != NO_ENTRY; i = s->entries[i].next) {
+    if (0 == memcmp(s->entries[i].key, key, GOST512_OUTPUT_BYTES)) {
+      return &s->entries[i];
+    }
+  }
+  return NULL;
+}
+
+static void unlink_entry(cache_shard_st *s, int32_t index) {
+  cache_entry_st *e = &s->entries[index];
+  int32_t *link = bucket_of(s, e->key);
+  while (*link != index) {
+    link = &s->entries[*link].next;
+  }
+  *link = e->next;
+  e->used = 0;
+}
+
+static void insert(cache_shard_st *s, const uint8_t *key, uint64_t pk_tag,
+                   int result) {
+  // CLOCK: skip recently used entries, clearing their marks
+  for (;;) {
+    cache_entry_st *e = &s->entries[s->hand];
+    if (!e->used || !e->referenced) {
+      break;
+    }
+    e->referenced = 0;
+    s->hand = (s->hand + 1) % s->count;
+  }
+
+  const int32_t index = (int32_t)s->hand;
+  cache_entry_st *e = &s->entries[index];
+  s->hand = (s->hand + 1) % s->count;
+  if (e->used) {
+    unlink_entry(s, index);
+    s->stats.evictions++;
+  }
+
+  memcpy(e->key, key, GOST512_OUTPUT_BYTES);
+  e->pk_tag = pk_tag;
+  e->result = result;
+  e->used = 1;
+  e->referenced = 0;
+  int32_t *bucket = bucket_of(s, key);
+  e->next = *bucket;
+  *bucket = index;
+  s->stats.insertions++;
+}
+
+static void reset_shard(cache_shard_st *s) {
+  for (size_t i = 0; i <= s->bucket_mask; ++i) {
+    s->buckets[i] = NO_ENTRY;
+  }
+  for (size_t i = 0; i < s->count; ++i) {
+    s->entries[i].used = 0;
+  }
+  s->hand = 0;
+}
+
+shipovnik_verify_cache_t *
+shipovnik_verify_cache_new(const shipovnik_verify_cache_config_t *config) {
+  const shipovnik_verify_cache_config_t defaults = {0, 0, 0};
+  if (NULL == config) {
+    config = &defaults;
+  }
+
+  size_t entries =
+      config->entries ? config->entries : SHIPOVNIK_VERIFY_CACHE_ENTRIES;
+  size_t shard_count =
+      config->shards ? config->shards : SHIPOVNIK_VERIFY_CACHE_SHARDS;
+  if (shard_count > entries) {
+    shard_count = entries;
+  }
+  const size_t per_shard = (entries + shard_count - 1) / shard_count;
+  if (per_shard > INT32_MAX) {
+    return NULL;
+  }
+
+  shipovnik_verify_cache_t *cache = calloc(1, sizeof(shipovnik_verify_cache_t));
+  if (NULL == cache) {
+    return NULL;
+  }
+  cache->store_failures = config->store_failures;
+  cache->shards = calloc(shard_count, sizeof(cache_shard_st));
+  if (NULL == cache->shards) {
+    free(cache);
+    return NULL;
+  }
+
+  for (; cache->shard_count < shard_count; ++cache->shard_count) {
+    cache_shard_st *s = &cache->shards[cache->shard_count];
+    s->count = per_shard;
+    s->bucket_mask = round_up_pow2(per_shard) - 1;
+    s->entries = calloc(s->count, sizeof(cache_entry_st));
+    s->buckets = malloc((s->bucket_mask + 1) * sizeof(int32_t));
+    if (NULL == s->entries || NULL == s->buckets) {
+      free(s->entries);
+      free(s->buckets);
+      shipovnik_verify_cache_free(cache);
+      return NULL;
+    }
+    pthread_mutex_init(&s->lock, NULL);
+    reset_shard(s);
+  }
+
+  return cache;
+}
+
+void shipovnik_verify_cache_free(shipovnik_verify_cache_t *cache) {
+  if (NULL == cache) {
+    return;
+  }
+
+  for (size_t i = 0; i < cache->shard_count; ++i) {
+    pthread_mutex_destroy(&cache->shards[i].lock);
+    free(cache->shards[i].entries);
+    free(cache->shards[i].buckets);
+  }
+  free(cache->shards);
+  free(cache);
+}
+
+int shipovnik_verify_cached(shipovnik_verify_cache_t *cache, const uint8_t *pk,
+                            const uint8_t *sig, size_t sig_len,
+                            const uint8_t *msg, size_t msg_len) {
+  if (NULL == cache) {
+    return shipovnik_verify_checked(pk, sig, sig_len, msg, msg_len, SIZE_MAX);
+  }
+
+  ALLOC_ON_STACK(uint8_t, key, GOST512_OUTPUT_BYTES);
+  streebog_512_f(msg, msg_len, key);
+
+  streebog_ctx_t ctx;
+  streebog_512_init(&ctx);
+  streebog_512_update(&ctx, pk, SHIPOVNIK_PUBLICKEYBYTES);
+  streebog_512_update(&ctx, sig, sig_len);
+  streebog_512_update(&ctx, key, GOST512_OUTPUT_BYTES);
+  streebog_512_final(&ctx, key);
+
+  cache_shard_st *s = shard_of(cache, key);
+  pthread_mutex_lock(&s->lock);
+  cache_entry_st *e = find(s, key);
+  if (NULL != e) {
+    e->referenced = 1;
+    s->stats.hits++;
+    const int result = e->result;
+    pthread_mutex_unlock(&s->lock);
+    return result;
+  }
+  s->stats.misses++;
+  pthread_mutex_unlock(&s->lock);
+
+  const int result =
+      shipovnik_verify_checked(pk, sig, sig_len, msg, msg_len, SIZE_MAX);
+  if (SHIPOVNIK_VERIFY_ERROR == result ||
+      (SHIPOVNIK_VERIFY_OK != result && !cache->store_failures)) {
+    return result;
+  }
+
+  pthread_mutex_lock(&s->lock);
+  // another thread may have verified the same signature meanwhile
+  if (NULL == find(s, key)) {
+    insert(s, key, load_u64(pk), result);
+  }
+  pthread_mutex_unlock(&s->lock);
+
+  return result;
+}
+
+void shipovnik_verify_cache_invalidate(shipovnik_verify_cache_t *cache,
+                                       const uint8_t *pk) {
+  // entries do not keep the whole key, so the tag may drop a few results of
+  // other keys too
+  const uint64_t pk_tag = load_u64(pk);
+
+  for (size_t i = 0; i < cache->shard_count; ++i) {
+    cache_shard_st *s = &cache->shards[i];
+    pthread_mutex_lock(&s->lock);
+    for (size_t j = 0; j < s->count; ++j) {
+      if (s->entries[j].used && s->entries[j].pk_tag == pk_tag) {
+        unlink_entry(s, (int32_t)j);
+        s->stats.invalidations++;
+      }
+    }
+    pthread_mutex_unlock(&s->lock);
+  }
+}
+
+void shipovnik_verify_cache_clear(shipovnik_verify_cache_t *cache) {
+  for (size_t i = 0; i < cache->shard_count; ++i) {
+    cache_shard_st *s = &cache->shards[i];
+    pthread_mutex_lock(&s->lock);
+    for (size_t j = 0; j < s->count; ++j) {
+      s->stats.invalidations += s->entries[j].used;
+    }
+    reset_shard(s);
+    pthread_mutex_unlock(&s->lock);
+  }
+}
+
+void shipovnik_verify_cache_stats(shipovnik_verify_cache_t *cache,
+                                  shipovnik_verify_cache_stats_t *stats) {
+  memset(stats, 0, sizeof(*stats));
+  for (size_t i = 0; i < cache->shard_count; ++i) {
+    cache_shard_st *s = &cache->shards[i];
+    pthread_mutex_lock(&s->lock);
+    stats->hits += s->stats.hits;
+    stats->misses += s->stats.misses;
+    stats->insertions += s->stats.insertions;
+    stats->evictions += s->stats.evictions;
+    stats->invalidations += s->stats.invalidations;
+    pthread_mutex_unlock(&s->lock);
+  }
+}